@@ -0,0 +1,40 @@
+#include <cstdio>
+#include <benchmark/benchmark.h>
+#include "NetworkGenerator.h"
+#include "Networks.h"
+#include "Checkpoint.h"
+#include "Metrics.h"
+
+// time for which a checkpoint holds the simulation compared to the whole save. Only the copy of the state
+// runs under the exclusive state lock on the timing wheel thread, indexing, encoding and writing happen after
+// the simulation has continued, so the pause (pause_*_us) should be a small part of the iteration time.
+static void BM_Checkpoint_Pause(benchmark::State &state)
+{
+    NetworkParameters parameters;
+    parameters.nColumns = parameters.nRows = 120;
+    parameters.nVehicles = state.range(0);
+    std::vector<std::shared_ptr<Street>> streets;
+    std::vector<std::shared_ptr<Intersection>> intersections;
+    std::vector<std::shared_ptr<Vehicle>> vehicles;
+    NetworkGenerator(parameters).generate(streets, intersections, vehicles);
+
+    Checkpoint checkpoint(streets, intersections, vehicles);
+    std::string filename = "checkpoint_bench.ck";
+    Histogram &pauseTime = MetricsRegistry::getInstance().getHistogram("checkpoint.pause_us");
+    pauseTime.reset();
+
+    // a paused wheel is advanced by a single tick for every capture
+    TrafficObject::getTimingWheel().pause();
+    for (auto _ : state)
+    {
+        checkpoint.save(filename);
+    }
+    TrafficObject::getTimingWheel().resume();
+
+    std::remove(filename.c_str());
+    state.counters["vehicles"] = vehicles.size();
+    state.counters["pause_p50_us"] = pauseTime.getPercentile(50);
+    state.counters["pause_max_us"] = pauseTime.getMax();
+    releaseTrafficObjects(streets, intersections, vehicles);
+}
+BENCHMARK(BM_Checkpoint_Pause)->ArgName("vehicles")->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,59 @@
+#include <chrono>
+#include <thread>
+#include <benchmark/benchmark.h>
+#include "Logger.h"
+
+// cost of a call whose level is filtered out, like the per-vehicle debug records of a normal run
+static void BM_Logger_Filtered(benchmark::State &state)
+{
+    Logger &logger = Logger::getInstance();
+    LogLevel level = logger.getLevel();
+    logger.setLevel(logInfo);
+    long i = 0;
+    for (auto _ : state)
+    {
+        logger.log(logDebug, "Vehicle #%ld is driving on street #%ld", i++, 0);
+    }
+    logger.setLevel(level);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Logger_Filtered);
+
+// one thread logging at a fixed rate in records/s, in bursts every 100 us. Records which do not fit into the ring
+// of the thread before the writer drains it are counted as dropped. The output goes to /dev/null for the rest of
+// the run, so that the terminal does not limit the writer.
+static void BM_Logger_Throughput(benchmark::State &state)
+{
+    const long rate = state.range(0);
+    const long nBurst = rate / 10000;
+    const auto period = std::chrono::microseconds(100);
+
+    Logger &logger = Logger::getInstance();
+    LogLevel level = logger.getLevel();
+    logger.setOutput("/dev/null");
+    logger.setLevel(logDebug);
+    logger.flush();
+    uint64_t dropped = logger.getDropped();
+    long nRecords = 0;
+    for (auto _ : state)
+    {
+        // one second of logging per iteration
+        auto next = std::chrono::steady_clock::now();
+        for (int b = 0; b < 10000; ++b)
+        {
+            for (long i = 0; i < nBurst; ++i)
+            {
+                logger.log(logDebug, "Vehicle #%ld is driving on street #%ld", nRecords++, b);
+            }
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+    logger.flush();
+    logger.setLevel(level);
+    dropped = logger.getDropped() - dropped;
+    state.counters["records/sec"] = benchmark::Counter(nRecords, benchmark::Counter::kIsRate);
+    state.counters["dropped"] = dropped;
+    state.counters["dropped_pct"] = nRecords > 0 ? 100.0 * dropped / nRecords : 0.0;
+}
+BENCHMARK(BM_Logger_Throughput)->ArgName("rate")->Arg(100000)->Arg(1000000)->Iterations(3)->Unit(benchmark::kSecond)->UseRealTime();
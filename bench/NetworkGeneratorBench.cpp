@@ -0,0 +1,41 @@
+#include <cmath>
+#include <benchmark/benchmark.h>
+#include "NetworkGenerator.h"
+#include "Networks.h"
+
+// generate a network of the given layout with about nIntersections intersections and a vehicle on every other street.
+// The largest networks take about 3 GB.
+static void BM_NetworkGenerator_Generate(benchmark::State &state)
+{
+    const NetworkLayout layout = static_cast<NetworkLayout>(state.range(0));
+    const int nIntersections = static_cast<int>(state.range(1));
+    NetworkParameters parameters;
+    parameters.layout = layout;
+    parameters.nColumns = parameters.nRows = static_cast<int>(std::sqrt(nIntersections));
+    parameters.nSpokes = 64;
+    parameters.nRings = nIntersections / parameters.nSpokes;
+    parameters.vehicleDensity = 0.5;
+    NetworkGenerator generator(parameters);
+    generator.setThreads(static_cast<int>(state.range(2)));
+
+    size_t nObjects = 0;
+    for (auto _ : state)
+    {
+        std::vector<std::shared_ptr<Street>> streets;
+        std::vector<std::shared_ptr<Intersection>> intersections;
+        std::vector<std::shared_ptr<Vehicle>> vehicles;
+        generator.generate(streets, intersections, vehicles);
+        nObjects += streets.size() + intersections.size() + vehicles.size();
+
+        // releasing the network is not part of the measurement
+        state.PauseTiming();
+        releaseTrafficObjects(streets, intersections, vehicles);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(nObjects);
+}
+BENCHMARK(BM_NetworkGenerator_Generate)
+    ->ArgNames({"layout", "intersections", "threads"})
+    ->ArgsProduct({{layoutGrid, layoutRadial, layoutRandom}, {10000, 1000000}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
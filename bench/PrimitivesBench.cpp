@@ -0,0 +1,190 @@
+#include <future>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "SpatialGrid.h"
+#include "TrafficLight.h"
+#include "Intersection.h"
+#include "Street.h"
+#include "Vehicle.h"
+
+// send a batch of messages and receive them again on the same thread, so the queue is never contended
+static void BM_MessageQueue_SendReceive(benchmark::State &state)
+{
+    const size_t nMessages = state.range(0);
+    MessageQueue<TrafficLightPhase> queue;
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < nMessages; ++i)
+        {
+            queue.send(i % 2 ? TrafficLightPhase::green : TrafficLightPhase::red);
+        }
+        for (size_t i = 0; i < nMessages; ++i)
+        {
+            benchmark::DoNotOptimize(queue.receive());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * nMessages);
+}
+BENCHMARK(BM_MessageQueue_SendReceive)->Arg(1)->Arg(64)->Arg(4096);
+
+// a producer thread sends while the benchmark thread receives, every message wakes up the receiver
+static void BM_MessageQueue_ProducerConsumer(benchmark::State &state)
+{
+    const size_t nMessages = state.range(0);
+    MessageQueue<TrafficLightPhase> queue;
+    for (auto _ : state)
+    {
+        std::thread producer([&queue, nMessages]() {
+            for (size_t i = 0; i < nMessages; ++i)
+            {
+                queue.send(TrafficLightPhase::green);
+            }
+        });
+        for (size_t i = 0; i < nMessages; ++i)
+        {
+            benchmark::DoNotOptimize(queue.receive());
+        }
+        producer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * nMessages);
+}
+BENCHMARK(BM_MessageQueue_ProducerConsumer)->Arg(4096)->UseRealTime();
+
+// queue vehicles at an approach and admit them again in platoons of the given size without headway
+static void BM_WaitingVehicles_PushPermit(benchmark::State &state)
+{
+    const size_t nVehicles = state.range(0);
+    const size_t platoonSize = state.range(1);
+    std::vector<std::shared_ptr<Vehicle>> vehicles;
+    for (size_t i = 0; i < nVehicles; ++i)
+    {
+        vehicles.push_back(std::make_shared<Vehicle>());
+    }
+
+    WaitingVehicles waitingVehicles;
+    std::vector<std::future<void>> futures(nVehicles);
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < nVehicles; ++i)
+        {
+            std::promise<void> promise;
+            futures[i] = promise.get_future();
+            waitingVehicles.pushBack(vehicles[i], std::move(promise));
+        }
+        while (waitingVehicles.getSize() > 0)
+        {
+            waitingVehicles.permitEntryToPlatoon(platoonSize, 1, 0);
+        }
+        for (auto &ftr : futures)
+        {
+            ftr.get();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * nVehicles);
+}
+BENCHMARK(BM_WaitingVehicles_PushPermit)->ArgsProduct({{64, 4096}, {1, 4, 64}});
+
+// list the outgoing streets of an intersection, as every vehicle does when it has crossed the intersection
+static void BM_Intersection_QueryStreets(benchmark::State &state)
+{
+    const size_t nStreets = state.range(0);
+    auto intersection = std::make_shared<Intersection>();
+    std::vector<std::shared_ptr<Street>> streets;
+    for (size_t i = 0; i < nStreets; ++i)
+    {
+        streets.push_back(std::make_shared<Street>());
+        intersection->addStreet(streets.back());
+    }
+
+    size_t incoming = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(intersection->queryStreets(streets[incoming]));
+        incoming = (incoming + 1) % nStreets;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Intersection_QueryStreets)->Arg(2)->Arg(4)->Arg(16);
+
+// advance the vehicles on a set of fully occupied streets by one step of the car-following model.
+// This is the position update which every vehicle thread used to do in Vehicle::drive.
+static void BM_Street_Update(benchmark::State &state)
+{
+    const size_t nVehicles = state.range(0);
+    const StreetModel model = static_cast<StreetModel>(state.range(1));
+    auto in = std::make_shared<Intersection>();
+    auto out = std::make_shared<Intersection>();
+    in->setPosition(0, 0);
+    out->setPosition(1000, 0);
+
+    // fill one street after the other, entering vehicles at full speed and moving them on until the queue
+    // in front of the stop line has grown back to the start of the street
+    std::vector<std::shared_ptr<Street>> streets;
+    std::vector<std::shared_ptr<Vehicle>> vehicles;
+    auto vehicle = std::make_shared<Vehicle>();
+    LaneHandle handle;
+    while (vehicles.size() < nVehicles)
+    {
+        auto street = std::make_shared<Street>();
+        street->setInIntersection(in);
+        street->setOutIntersection(out);
+        streets.push_back(street);
+        for (int nFailed = 0; nFailed < 50 && vehicles.size() < nVehicles; street->update(0.01))
+        {
+            if (street->enter(vehicle, out, street->getCarFollowingParameters().desiredSpeed, handle))
+            {
+                vehicles.push_back(vehicle);
+                vehicle = std::make_shared<Vehicle>();
+                nFailed = 0;
+            }
+            else
+            {
+                ++nFailed;
+            }
+        }
+    }
+    for (auto &street : streets)
+    {
+        street->setModel(model);
+    }
+
+    size_t nUpdates = 0;
+    for (auto _ : state)
+    {
+        for (auto &street : streets)
+        {
+            nUpdates += street->update(0.01);
+        }
+    }
+    state.SetItemsProcessed(nUpdates);
+}
+BENCHMARK(BM_Street_Update)->ArgsProduct({{1000, 100000}, {modelMicroscopic, modelMesoscopic}});
+
+// rebuild the culling grid of the renderer for vehicles scattered over a 4000x4000 map, as it is done for every
+// new frame. The build is a counting sort, so items/sec should stay flat from 10k to 1M vehicles.
+static void BM_SpatialGrid_Build(benchmark::State &state)
+{
+    const size_t nItems = state.range(0);
+    const int nThreads = static_cast<int>(state.range(1));
+    std::mt19937 eng(42);
+    std::uniform_real_distribution<float> distr(0.0f, 4000.0f);
+    std::vector<float> xs(nItems), ys(nItems);
+    for (size_t i = 0; i < nItems; ++i)
+    {
+        xs[i] = distr(eng);
+        ys[i] = distr(eng);
+    }
+
+    SpatialGrid grid;
+    grid.setBounds(4000.0f, 4000.0f);
+    for (auto _ : state)
+    {
+        grid.build(xs, ys, nThreads);
+        benchmark::DoNotOptimize(grid.getCellCount(0, 0));
+    }
+    state.SetItemsProcessed(state.iterations() * nItems);
+}
+BENCHMARK(BM_SpatialGrid_Build)->ArgNames({"items", "threads"})->ArgsProduct({{10000, 100000, 1000000}, {1, 4}})->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,45 @@
+#include <random>
+#include <benchmark/benchmark.h>
+#include <opencv2/highgui.hpp>
+#include "Graphics.h"
+
+// render the Paris map with 50k vehicles using a varying number of tile rasterization threads
+static void BM_Graphics_RenderParis(benchmark::State &state)
+{
+    const std::string filename = "../data/paris.jpg";
+    cv::Mat map = cv::imread(filename);
+    if (map.empty())
+    {
+        state.SkipWithError("could not load ../data/paris.jpg, run the benchmark from the build directory");
+        return;
+    }
+
+    // scatter vehicles uniformly over the map
+    FrameSnapshot frame;
+    const size_t nVehicles = state.range(1);
+    std::mt19937 eng(42);
+    std::uniform_real_distribution<float> distrX(0, map.cols), distrY(0, map.rows);
+    for (size_t i = 0; i < nVehicles; ++i)
+    {
+        frame.vehicleIds.push_back(static_cast<int>(i));
+        frame.vehicleX.push_back(distrX(eng));
+        frame.vehicleY.push_back(distrY(eng));
+    }
+
+    Graphics graphics;
+    graphics.setBgFilename(filename);
+    graphics.setRenderThreads(static_cast<int>(state.range(0)));
+    graphics.loadBackgroundImg();
+    for (auto _ : state)
+    {
+        // move all vehicles a little, so every frame has to be redrawn
+        for (size_t i = 0; i < nVehicles; ++i)
+        {
+            frame.vehicleX[i] = frame.vehicleX[i] + 1.0f < map.cols ? frame.vehicleX[i] + 1.0f : 0.0f;
+        }
+        ++frame.frameNumber;
+        benchmark::DoNotOptimize(graphics.renderFrame(frame).data);
+    }
+    state.counters["fps"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Graphics_RenderParis)->ArgsProduct({{1, 2, 4, 8, 16}, {50000}})->Unit(benchmark::kMillisecond)->UseRealTime();
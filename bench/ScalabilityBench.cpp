@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <benchmark/benchmark.h>
+#include "Networks.h"
+#include "StreetScheduler.h"
+#include "Metrics.h"
+
+// the peak resident set size (high-water mark) of the process is reset to the current one, so that every
+// configuration reports its own peak
+static void resetPeakResident()
+{
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+// peak resident set size in MB since the last reset
+static double getPeakResidentMegabytes()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return std::stol(line.substr(6)) / 1024.0; // in kB
+        }
+    }
+    return 0.0;
+}
+
+// sweep vehicle count, intersection count and street scheduler threads on a synthetic grid city. Every run
+// simulates a fixed amount of time, the results are meant to be compared across releases as CSV:
+//   ./traffic_bench --benchmark_filter=Scalability --benchmark_format=csv > scalability.csv
+// Known limit: every vehicle and every intersection runs on a thread of its own, so the sweep stops at 10000
+// vehicles on a 16x16 grid. 100000 vehicles exceed the thread limit of a typical kernel, and on one CPU a 32x32
+// grid with 1000 vehicles already needs about 65 s for the 5 s of simulated time, with 10000 vehicles it does not
+// finish within 15 minutes. Beyond that, the runs mostly measure how the operating system schedules the threads.
+static void BM_Scalability_Grid(benchmark::State &state)
+{
+    const int nVehicles = static_cast<int>(state.range(0));
+    const int gridSize = static_cast<int>(state.range(1));
+    const int nThreads = static_cast<int>(state.range(2));
+    const long duration = 5000; // simulated time per run in ms
+
+    Histogram &tickDuration = MetricsRegistry::getInstance().getHistogram("scheduler.tick_us");
+    Histogram &waitTime = MetricsRegistry::getInstance().getHistogram("intersection.wait_ms");
+    long nVehicleUpdates = 0, nCrossings = 0;
+    double peakRss = 0.0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        resetPeakResident();
+        std::vector<std::shared_ptr<Street>> streets;
+        std::vector<std::shared_ptr<Intersection>> intersections;
+        std::vector<std::shared_ptr<Vehicle>> vehicles;
+        createTrafficObjects_Grid(streets, intersections, vehicles, gridSize, gridSize, nVehicles);
+        StreetScheduler scheduler;
+        scheduler.setStreets(streets);
+        scheduler.setThreads(nThreads);
+        tickDuration.reset();
+        waitTime.reset();
+        state.ResumeTiming();
+
+        for (auto &intersection : intersections)
+        {
+            intersection->simulate();
+        }
+        for (auto &vehicle : vehicles)
+        {
+            vehicle->simulate();
+        }
+        scheduler.simulate();
+
+        long end = TrafficObject::getSimulationTime() + duration;
+        while (TrafficObject::getSimulationTime() < end)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        state.PauseTiming();
+        peakRss = std::max(peakRss, getPeakResidentMegabytes());
+        scheduler.stop();
+        stopTrafficObjects(intersections, vehicles);
+        nVehicleUpdates += scheduler.getVehicleUpdates();
+        for (auto &intersection : intersections)
+        {
+            nCrossings += intersection->getThroughput();
+        }
+        releaseTrafficObjects(streets, intersections, vehicles);
+        state.ResumeTiming();
+    }
+
+    state.counters["intersections"] = gridSize * gridSize;
+    state.counters["vehicle-updates/sec"] = benchmark::Counter(nVehicleUpdates, benchmark::Counter::kIsRate);
+    state.counters["crossings/sec"] = benchmark::Counter(nCrossings, benchmark::Counter::kIsRate);
+    state.counters["tick_p50_us"] = tickDuration.getPercentile(50);
+    state.counters["tick_p99_us"] = tickDuration.getPercentile(99);
+    state.counters["wait_p50_ms"] = waitTime.getPercentile(50);
+    state.counters["wait_p99_ms"] = waitTime.getPercentile(99);
+    state.counters["rss_peak_mb"] = peakRss; // while the network is built and simulated
+}
+BENCHMARK(BM_Scalability_Grid)
+    ->ArgNames({"vehicles", "grid", "threads"})
+    ->ArgsProduct({{100, 1000}, {4, 8, 16}, {1, 2, 4, 8}})
+    ->ArgsProduct({{10000}, {16}, {1, 2, 4, 8}}) // smaller grids have no room for 10000 vehicles
+    ->Iterations(1)
+    ->Unit(benchmark::kSecond)
+    ->UseRealTime();
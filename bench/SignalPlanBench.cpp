@@ -0,0 +1,68 @@
+#include <chrono>
+#include <thread>
+#include <benchmark/benchmark.h>
+#include "Networks.h"
+#include "Vehicle.h"
+#include "StreetScheduler.h"
+#include "Metrics.h"
+
+// arterial of two parallel rows of intersections with uncoordinated (0) and coordinated (1) signal plans. Vehicles
+// keep straight on, so they stay on a row until its end and only then turn, and the wave of the row can carry
+// them from light to light. Both plans are compared by crossings/sec and the wait at the lights, at a light and a
+// congested load.
+static void BM_GreenWave_Arterial(benchmark::State &state)
+{
+    const bool isCoordinated = state.range(0) != 0;
+    const int nColumns = 8, nRows = 2, nVehicles = static_cast<int>(state.range(1));
+    const long duration = 30000; // simulated time per run in ms
+    const double speed = isCoordinated ? CarFollowingParameters().desiredSpeed : 0.0;
+
+    Histogram &waitTime = MetricsRegistry::getInstance().getHistogram("intersection.wait_ms");
+    long nCrossings = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::vector<std::shared_ptr<Street>> streets;
+        std::vector<std::shared_ptr<Intersection>> intersections;
+        std::vector<std::shared_ptr<Vehicle>> vehicles;
+        createTrafficObjects_Grid(streets, intersections, vehicles, nColumns, nRows, nVehicles, 200.0, speed);
+        for (auto &vehicle : vehicles)
+        {
+            vehicle->setRouteChoice(routeStraight);
+        }
+        StreetScheduler scheduler;
+        scheduler.setStreets(streets);
+        waitTime.reset();
+        state.ResumeTiming();
+
+        for (auto &intersection : intersections)
+        {
+            intersection->simulate();
+        }
+        for (auto &vehicle : vehicles)
+        {
+            vehicle->simulate();
+        }
+        scheduler.simulate();
+
+        long end = TrafficObject::getSimulationTime() + duration;
+        while (TrafficObject::getSimulationTime() < end)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        state.PauseTiming();
+        scheduler.stop();
+        stopTrafficObjects(intersections, vehicles);
+        for (auto &intersection : intersections)
+        {
+            nCrossings += intersection->getThroughput();
+        }
+        releaseTrafficObjects(streets, intersections, vehicles);
+        state.ResumeTiming();
+    }
+    state.counters["crossings/sec"] = benchmark::Counter(nCrossings, benchmark::Counter::kIsRate);
+    state.counters["wait_p50_ms"] = waitTime.getPercentile(50);
+    state.counters["wait_p99_ms"] = waitTime.getPercentile(99);
+}
+BENCHMARK(BM_GreenWave_Arterial)->ArgNames({"coordinated", "vehicles"})->ArgsProduct({{0, 1}, {60, 200}})->Iterations(1)->Unit(benchmark::kSecond)->UseRealTime();
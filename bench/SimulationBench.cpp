@@ -0,0 +1,77 @@
+#include <chrono>
+#include <thread>
+#include <benchmark/benchmark.h>
+#include "Networks.h"
+#include "SignalController.h"
+#include "StreetScheduler.h"
+
+typedef void (*NetworkBuilder)(std::vector<std::shared_ptr<Street>> &, std::vector<std::shared_ptr<Intersection>> &, std::vector<std::shared_ptr<Vehicle>> &, std::string &, int);
+
+// run a whole network with all of its threads for the given number of simulated seconds. The simulation runs
+// in real time, so ticks/sec shows whether the street scheduler keeps up with its step (100 ticks/sec at 10 ms).
+// All lights are switched by a signal controller with fixed-time (0) or actuated (1) control, crossings/sec
+// compares how many vehicles the policies let through.
+static void BM_Simulation_Network(benchmark::State &state, NetworkBuilder createTrafficObjects)
+{
+    const int nVehicles = static_cast<int>(state.range(0));
+    const long duration = 1000 * state.range(1);
+    const bool isActuated = state.range(2) != 0;
+    long nSteps = 0, nVehicleUpdates = 0, nCrossings = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::vector<std::shared_ptr<Street>> streets;
+        std::vector<std::shared_ptr<Intersection>> intersections;
+        std::vector<std::shared_ptr<Vehicle>> vehicles;
+        std::string filename;
+        createTrafficObjects(streets, intersections, vehicles, filename, nVehicles);
+        StreetScheduler scheduler;
+        scheduler.setStreets(streets);
+        std::shared_ptr<SignalControlPolicy> policy;
+        if (isActuated)
+            policy = std::make_shared<ActuatedPolicy>();
+        else
+            policy = std::make_shared<FixedTimePolicy>();
+        SignalController controller(policy);
+        for (auto &intersection : intersections)
+        {
+            controller.addIntersection(intersection);
+        }
+        state.ResumeTiming();
+
+        for (auto &intersection : intersections)
+        {
+            intersection->simulate();
+        }
+        for (auto &vehicle : vehicles)
+        {
+            vehicle->simulate();
+        }
+        scheduler.simulate();
+        controller.simulate();
+
+        long end = TrafficObject::getSimulationTime() + duration;
+        while (TrafficObject::getSimulationTime() < end)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        state.PauseTiming();
+        controller.stop();
+        scheduler.stop();
+        stopTrafficObjects(intersections, vehicles);
+        nSteps += scheduler.getSteps();
+        nVehicleUpdates += scheduler.getVehicleUpdates();
+        for (auto &intersection : intersections)
+        {
+            nCrossings += intersection->getThroughput();
+        }
+        releaseTrafficObjects(streets, intersections, vehicles);
+        state.ResumeTiming();
+    }
+    state.counters["ticks/sec"] = benchmark::Counter(nSteps, benchmark::Counter::kIsRate);
+    state.counters["vehicle-updates/sec"] = benchmark::Counter(nVehicleUpdates, benchmark::Counter::kIsRate);
+    state.counters["crossings/sec"] = benchmark::Counter(nCrossings, benchmark::Counter::kIsRate);
+}
+BENCHMARK_CAPTURE(BM_Simulation_Network, Paris, createTrafficObjects_Paris)->ArgNames({"vehicles", "seconds", "actuated"})->ArgsProduct({{10, 100, 1000}, {5}, {0, 1}})->Unit(benchmark::kSecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Simulation_Network, NYC, createTrafficObjects_NYC)->ArgNames({"vehicles", "seconds", "actuated"})->ArgsProduct({{10, 100, 1000}, {5}, {0, 1}})->Unit(benchmark::kSecond)->UseRealTime();
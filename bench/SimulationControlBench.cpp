@@ -0,0 +1,85 @@
+#include <chrono>
+#include <future>
+#include <thread>
+#include <benchmark/benchmark.h>
+#include "Networks.h"
+#include "SimulationControl.h"
+#include "StreetScheduler.h"
+
+// a platoon is admitted while the simulation is paused, so the entry of all but its first vehicle is due on timers
+// which the paused wheel does not fire. Stopping the approach must still grant entry to every admitted vehicle,
+// otherwise their threads never finish.
+static void BM_WaitingVehicles_ReleaseWhilePaused(benchmark::State &state)
+{
+    const size_t nVehicles = state.range(0);
+    SimulationControl &control = SimulationControl::getInstance();
+    control.pause();
+    for (auto _ : state)
+    {
+        WaitingVehicles waitingVehicles;
+        std::vector<std::future<void>> entries;
+        for (size_t k = 0; k < nVehicles; ++k)
+        {
+            std::promise<void> promise;
+            entries.push_back(promise.get_future());
+            waitingVehicles.pushBack(nullptr, std::move(promise));
+        }
+        waitingVehicles.permitEntryToPlatoon(nVehicles, 1, 200);
+        waitingVehicles.releaseAll();
+
+        for (auto &entry : entries)
+        {
+            if (entry.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                state.SkipWithError("entry of a platoon vehicle has not been granted on stop");
+                break;
+            }
+        }
+    }
+    control.resume();
+    state.SetItemsProcessed(state.iterations() * nVehicles);
+}
+BENCHMARK(BM_WaitingVehicles_ReleaseWhilePaused)->Arg(8);
+
+// pause a running grid and stop it, like pressing space and then q in the main program. The time to stop must not
+// depend on the wheel, vehicles waiting for a platoon entry are released by their intersection.
+static void BM_Simulation_StopWhilePaused(benchmark::State &state)
+{
+    const int nVehicles = static_cast<int>(state.range(0));
+    SimulationControl &control = SimulationControl::getInstance();
+    double stopTime = 0.0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::vector<std::shared_ptr<Street>> streets;
+        std::vector<std::shared_ptr<Intersection>> intersections;
+        std::vector<std::shared_ptr<Vehicle>> vehicles;
+        createTrafficObjects_Grid(streets, intersections, vehicles, 4, 4, nVehicles);
+        StreetScheduler scheduler;
+        scheduler.setStreets(streets);
+        for (auto &intersection : intersections)
+        {
+            intersection->simulate();
+        }
+        for (auto &vehicle : vehicles)
+        {
+            vehicle->simulate();
+        }
+        scheduler.simulate();
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+        control.pause();
+        state.ResumeTiming();
+
+        auto start = std::chrono::steady_clock::now();
+        scheduler.stop();
+        stopTrafficObjects(intersections, vehicles);
+        stopTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        state.PauseTiming();
+        control.resume();
+        releaseTrafficObjects(streets, intersections, vehicles);
+        state.ResumeTiming();
+    }
+    state.counters["stop_ms"] = stopTime / state.iterations();
+}
+BENCHMARK(BM_Simulation_StopWhilePaused)->Arg(400)->Iterations(3)->Unit(benchmark::kMillisecond)->UseRealTime();
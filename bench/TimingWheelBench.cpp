@@ -0,0 +1,72 @@
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "TimingWheel.h"
+
+// insert timers with random delays spread over all levels of the wheel and let them fire
+static void BM_TimingWheel_ScheduleAndFire(benchmark::State &state)
+{
+    const size_t nTimers = state.range(0);
+    std::mt19937 eng(42);
+    std::uniform_int_distribution<uint64_t> distr(1, 1 << 20);
+    std::vector<uint64_t> delays(nTimers);
+    for (auto &delay : delays)
+    {
+        delay = distr(eng);
+    }
+
+    TimingWheel wheel;
+    wheel.reserve(nTimers);
+    size_t fired = 0;
+    for (auto _ : state)
+    {
+        for (auto delay : delays)
+        {
+            wheel.schedule(delay, [&fired]() { ++fired; });
+        }
+        wheel.advance(1 << 20);
+    }
+    benchmark::DoNotOptimize(fired);
+    state.SetItemsProcessed(state.iterations() * nTimers);
+}
+BENCHMARK(BM_TimingWheel_ScheduleAndFire)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+
+// insert and cancel timers without ever advancing the wheel
+static void BM_TimingWheel_ScheduleAndCancel(benchmark::State &state)
+{
+    const size_t nTimers = state.range(0);
+    TimingWheel wheel;
+    wheel.reserve(nTimers);
+    std::vector<TimingWheel::TimerId> ids(nTimers);
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < nTimers; ++i)
+        {
+            ids[i] = wheel.schedule(1000 + i, []() {});
+        }
+        for (auto id : ids)
+        {
+            wheel.cancel(id);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * nTimers * 2);
+}
+BENCHMARK(BM_TimingWheel_ScheduleAndCancel)->Arg(1 << 10)->Arg(1 << 20);
+
+// cost of advancing a single tick while millions of timers are pending on higher levels
+static void BM_TimingWheel_TickWithPending(benchmark::State &state)
+{
+    const size_t nPending = state.range(0);
+    TimingWheel wheel;
+    wheel.reserve(nPending);
+    for (size_t i = 0; i < nPending; ++i)
+    {
+        wheel.schedule(uint64_t(1) << 30, []() {});
+    }
+    for (auto _ : state)
+    {
+        wheel.advance(1);
+    }
+    state.counters["pending"] = wheel.getPending();
+}
+BENCHMARK(BM_TimingWheel_TickWithPending)->Arg(1 << 20)->Arg(1 << 22);
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cstdio>
+#include <benchmark/benchmark.h>
+#include "NetworkGenerator.h"
+#include "Networks.h"
+#include "StreetScheduler.h"
+#include "Trajectory.h"
+
+// cost of recording trajectories relative to the street updates they sample. Every iteration advances all
+// streets by 100 ms of simulation time (10 steps of 10 ms). Frames are recorded with the given period in ms, 0
+// turns recording off, 10 records every step and 100 the default of one frame per iteration. The writer thread
+// encodes concurrently, frames which are due while its queue is full are dropped and counted. Compare the times
+// with recording off for the overhead. The CPU time is that of the stepping thread alone, which is what recording
+// costs the simulation when the writer has a core of its own.
+static void BM_Trajectory_Overhead(benchmark::State &state)
+{
+    const long nVehicles = state.range(0);
+    const long period = state.range(1);
+    NetworkParameters parameters;
+    parameters.nColumns = parameters.nRows = 120;
+    parameters.nVehicles = nVehicles;
+    std::vector<std::shared_ptr<Street>> streets;
+    std::vector<std::shared_ptr<Intersection>> intersections;
+    std::vector<std::shared_ptr<Vehicle>> vehicles;
+    NetworkGenerator(parameters).generate(streets, intersections, vehicles);
+
+    StreetScheduler scheduler;
+    scheduler.setStreets(streets);
+    scheduler.setThreads(1);
+    std::string filename = "trajectory_bench.trj";
+    std::shared_ptr<TrajectoryRecorder> recorder;
+    if (period > 0)
+    {
+        recorder = std::make_shared<TrajectoryRecorder>(filename, period);
+        scheduler.setRecorder(recorder);
+    }
+
+    // the simulation time is advanced by hand while the timing wheel is paused
+    TrafficObject::getTimingWheel().pause();
+    for (auto _ : state)
+    {
+        for (int step = 0; step < 10; ++step)
+        {
+            TrafficObject::setSimulationTime(TrafficObject::getSimulationTime() + scheduler.getStep());
+            scheduler.updateStreets();
+        }
+    }
+
+    if (recorder)
+    {
+        scheduler.setRecorder(nullptr);
+        recorder->stop();
+        double nFrames = static_cast<double>(state.iterations() * 100 / period - recorder->getDroppedFrames());
+        state.counters["bytes/vehicle-frame"] = recorder->getBytesWritten() / (vehicles.size() * std::max(1.0, nFrames));
+        state.counters["dropped"] = recorder->getDroppedFrames();
+        std::remove(filename.c_str());
+    }
+    TrafficObject::getTimingWheel().resume();
+    state.counters["vehicles"] = vehicles.size();
+    releaseTrafficObjects(streets, intersections, vehicles);
+}
+BENCHMARK(BM_Trajectory_Overhead)
+    ->ArgNames({"vehicles", "period"})
+    ->ArgsProduct({{10000, 100000}, {0, 10, 100}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <unordered_map>
+#include "SimulationControl.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "Checkpoint.h"
+
+// values are stored in the byte order of the machine, checkpoints are not meant to be moved between architectures
+template <typename T>
+static void writeValue(std::string &buffer, T value)
+{
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// returns false if the buffer ends before the value
+template <typename T>
+static bool readValue(const std::string &buffer, size_t &offset, T &value)
+{
+    if (buffer.size() - offset < sizeof(T))
+    {
+        return false;
+    }
+    std::memcpy(&value, buffer.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+/* Implementation of class "Checkpoint" */
+
+Checkpoint::Checkpoint(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles)
+{
+    _streets = streets;
+    _intersections = intersections;
+    _vehicles = vehicles;
+}
+
+bool Checkpoint::save(const std::string &filename)
+{
+    // the state is copied by a timer callback under the exclusive state lock, so no street update can be in
+    // progress. The wheel does not advance while the callback runs, a paused wheel is advanced by a single tick for it
+    static Histogram &pauseTime = MetricsRegistry::getInstance().getHistogram("checkpoint.pause_us");
+    CapturedState state;
+    std::promise<void> prmsCaptured;
+    std::future<void> ftrCaptured = prmsCaptured.get_future();
+    long captureTime = 0;
+    TimingWheel &timingWheel = TrafficObject::getTimingWheel();
+    timingWheel.schedule(1, [this, &state, &prmsCaptured, &captureTime]() {
+        auto start = std::chrono::steady_clock::now();
+        capture(state);
+        captureTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        prmsCaptured.set_value();
+    });
+    timingWheel.step(1);
+    ftrCaptured.wait();
+    pauseTime.record(captureTime);
+
+    // the copy is encoded and written after the simulation has continued
+    std::string buffer;
+    encode(state, buffer);
+    Logger::getInstance().log(logInfo, "Checkpoint of %ld vehicles captured in %ld us, %ld bytes", _vehicles.size(), captureTime, buffer.size());
+    std::ofstream file(filename, std::ios::binary);
+    file.write(buffer.data(), buffer.size());
+
+    return static_cast<bool>(file);
+}
+
+void Checkpoint::capture(CapturedState &state)
+{
+    // vehicles cannot change streets while the state is copied, so every vehicle is seen exactly once. Only the
+    // streets and lights are read, the vehicles themselves are not touched
+    std::unique_lock<std::shared_mutex> stateLock(SimulationControl::getInstance().getStateMutex());
+    state.time = TrafficObject::getSimulationTime();
+    state.laneVehicles.reserve(_vehicles.size());
+    state.models.reserve(_streets.size());
+    state.throughputs.resize(_intersections.size());
+    state.plans.resize(_intersections.size());
+    state.phaseIndices.resize(_intersections.size());
+    state.phaseStarts.resize(_intersections.size());
+
+    for (size_t i = 0; i < _intersections.size(); ++i)
+    {
+        state.throughputs[i] = _intersections[i]->getThroughput();
+        _intersections[i]->getTrafficLight().getState(state.plans[i], state.phaseIndices[i], state.phaseStarts[i]);
+    }
+
+    for (size_t i = 0; i < _streets.size(); ++i)
+    {
+        state.models.push_back(static_cast<uint8_t>(_streets[i]->getModel()));
+        _streets[i]->getLaneVehicles(state.laneVehicles, state.laneSizes, state.lastExitTimes, state.roomRequests);
+        state.requestStreets.resize(state.roomRequests.size(), static_cast<uint32_t>(i));
+    }
+}
+
+void Checkpoint::encode(const CapturedState &state, std::string &buffer)
+{
+    std::unordered_map<int, uint32_t> vehicleIndex;
+    for (size_t i = 0; i < _vehicles.size(); ++i)
+    {
+        vehicleIndex[_vehicles[i]->getID()] = static_cast<uint32_t>(i);
+    }
+    std::unordered_map<const Intersection *, uint32_t> intersectionIndex;
+    for (size_t i = 0; i < _intersections.size(); ++i)
+    {
+        intersectionIndex[_intersections[i].get()] = static_cast<uint32_t>(i);
+    }
+
+    writeValue<uint32_t>(buffer, magic);
+    writeValue<uint32_t>(buffer, version);
+    writeValue<int64_t>(buffer, state.time);
+    writeValue<uint32_t>(buffer, static_cast<uint32_t>(_intersections.size()));
+    writeValue<uint32_t>(buffer, static_cast<uint32_t>(_streets.size()));
+    writeValue<uint32_t>(buffer, static_cast<uint32_t>(_vehicles.size()));
+
+    // fixed-time lights follow their plan in simulation time, actuated lights keep their phase
+    for (size_t i = 0; i < _intersections.size(); ++i)
+    {
+        const SignalPlan &plan = state.plans[i];
+        writeValue<int64_t>(buffer, state.throughputs[i]);
+        writeValue<int64_t>(buffer, plan.getOffset());
+        writeValue<uint32_t>(buffer, static_cast<uint32_t>(plan.getPhaseCount()));
+        for (size_t phase = 0; phase < plan.getPhaseCount(); ++phase)
+        {
+            writeValue<int64_t>(buffer, plan.getPhase(phase).duration);
+            writeValue<uint64_t>(buffer, plan.getPhase(phase).greenMask);
+        }
+        writeValue<uint32_t>(buffer, static_cast<uint32_t>(state.phaseIndices[i]));
+        writeValue<int64_t>(buffer, state.phaseStarts[i]);
+    }
+
+    // vehicles on the lanes of every street from the front to the back
+    std::vector<uint8_t> isOnStreet(_vehicles.size(), 0);
+    size_t lane = 0, k = 0;
+    for (size_t i = 0; i < _streets.size(); ++i)
+    {
+        int nLanes = _streets[i]->getLanes();
+        writeValue<uint8_t>(buffer, state.models[i]);
+        writeValue<uint32_t>(buffer, static_cast<uint32_t>(nLanes));
+        for (size_t end = lane + 2 * nLanes; lane < end; ++lane)
+        {
+            writeValue<int64_t>(buffer, state.lastExitTimes[lane]);
+            writeValue<uint32_t>(buffer, state.laneSizes[lane]);
+            for (size_t last = k + state.laneSizes[lane]; k < last; ++k)
+            {
+                const LaneVehicleState &vehicle = state.laneVehicles[k];
+                uint32_t index = vehicleIndex[vehicle.vehicleId];
+                isOnStreet[index] = 1;
+                writeValue<uint32_t>(buffer, index);
+                writeValue<double>(buffer, vehicle.position);
+                writeValue<double>(buffer, vehicle.speed);
+                writeValue<int64_t>(buffer, vehicle.exitTime);
+                writeValue<uint8_t>(buffer, vehicle.isEntryGranted ? 1 : 0);
+            }
+        }
+    }
+
+    // vehicles which are still waiting for room on their first street, those on a lane wait for their next street
+    std::vector<std::array<uint32_t, 3>> waiting; // vehicle, street and destination
+    for (size_t k = 0; k < state.roomRequests.size(); ++k)
+    {
+        uint32_t index = vehicleIndex[state.roomRequests[k].first];
+        if (!isOnStreet[index])
+        {
+            Street &street = *_streets[state.requestStreets[k]];
+            Intersection *destination = state.roomRequests[k].second < street.getLanes() ? street.getOutIntersection().get() : street.getInIntersection().get();
+            waiting.push_back({index, state.requestStreets[k], intersectionIndex[destination]});
+        }
+    }
+    std::sort(waiting.begin(), waiting.end());
+    writeValue<uint32_t>(buffer, static_cast<uint32_t>(waiting.size()));
+    for (auto &entry : waiting)
+    {
+        writeValue<uint32_t>(buffer, entry[0]);
+        writeValue<uint32_t>(buffer, entry[1]);
+        writeValue<uint32_t>(buffer, entry[2]);
+    }
+}
+
+bool Checkpoint::restore(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        Logger::getInstance().log(logError, "Checkpoint could not be opened");
+        return false;
+    }
+    std::string buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!apply(buffer))
+    {
+        Logger::getInstance().log(logError, "Checkpoint does not match the network (%ld intersections, %ld streets, %ld vehicles)",
+                                  _intersections.size(), _streets.size(), _vehicles.size());
+        return false;
+    }
+    Logger::getInstance().log(logInfo, "Checkpoint restored at %ld ms", TrafficObject::getSimulationTime());
+
+    return true;
+}
+
+bool Checkpoint::apply(const std::string &buffer)
+{
+    // the whole file is read and checked before any object is changed
+    size_t offset = 0;
+    auto read = [&buffer, &offset](auto &value) { return readValue(buffer, offset, value); };
+
+    uint32_t fileMagic, fileVersion, nIntersections, nStreets, nVehicles;
+    int64_t time;
+    if (!read(fileMagic) || !read(fileVersion) || !read(time) || !read(nIntersections) || !read(nStreets) || !read(nVehicles) ||
+        fileMagic != magic || fileVersion != version || nIntersections != _intersections.size() || nStreets != _streets.size() ||
+        nVehicles != _vehicles.size())
+    {
+        return false;
+    }
+
+    std::vector<int64_t> throughputs(nIntersections), phaseStarts(nIntersections);
+    std::vector<uint32_t> phaseIndices(nIntersections);
+    std::vector<SignalPlan> plans(nIntersections);
+    for (uint32_t i = 0; i < nIntersections; ++i)
+    {
+        int64_t planOffset;
+        uint32_t nPhases;
+        if (!read(throughputs[i]) || !read(planOffset) || !read(nPhases))
+        {
+            return false;
+        }
+        for (uint32_t phase = 0; phase < nPhases; ++phase)
+        {
+            int64_t duration;
+            uint64_t greenMask;
+            if (!read(duration) || !read(greenMask))
+            {
+                return false;
+            }
+            plans[i].addPhase(duration, greenMask);
+        }
+        plans[i].setOffset(planOffset);
+        if (!read(phaseIndices[i]) || !read(phaseStarts[i]))
+        {
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> models(nStreets), isSeen(nVehicles, 0);
+    std::vector<std::vector<std::vector<LaneVehicle>>> lanes(nStreets);
+    std::vector<std::vector<long>> lastExitTimes(nStreets);
+    for (uint32_t i = 0; i < nStreets; ++i)
+    {
+        uint32_t nLanes;
+        if (!read(models[i]) || !read(nLanes) || models[i] > modelMesoscopic || static_cast<int>(nLanes) != _streets[i]->getLanes())
+        {
+            return false;
+        }
+        lanes[i].resize(2 * nLanes);
+        lastExitTimes[i].resize(2 * nLanes);
+        for (uint32_t lane = 0; lane < 2 * nLanes; ++lane)
+        {
+            int64_t lastExitTime;
+            uint32_t count;
+            if (!read(lastExitTime) || !read(count) || static_cast<int>(count) > _streets[i]->getLaneCapacity())
+            {
+                return false;
+            }
+            lastExitTimes[i][lane] = lastExitTime;
+            for (uint32_t k = 0; k < count; ++k)
+            {
+                uint32_t index;
+                double position, speed;
+                int64_t exitTime;
+                uint8_t isEntryGranted;
+                if (!read(index) || !read(position) || !read(speed) || !read(exitTime) || !read(isEntryGranted) || index >= nVehicles || isSeen[index])
+                {
+                    return false;
+                }
+                isSeen[index] = 1;
+                lanes[i][lane].push_back(LaneVehicle{_vehicles[index], position, speed, exitTime, isEntryGranted != 0});
+            }
+        }
+    }
+
+    uint32_t nWaiting;
+    if (!read(nWaiting))
+    {
+        return false;
+    }
+    std::vector<uint32_t> waiting(3 * nWaiting);
+    for (uint32_t k = 0; k < nWaiting; ++k)
+    {
+        uint32_t *entry = &waiting[3 * k]; // vehicle, street and destination
+        if (!read(entry[0]) || !read(entry[1]) || !read(entry[2]) || entry[0] >= nVehicles || isSeen[entry[0]] || entry[1] >= nStreets || entry[2] >= nIntersections)
+        {
+            return false;
+        }
+        isSeen[entry[0]] = 1;
+    }
+
+    /* the checkpoint is valid, apply it to the network */
+
+    TrafficObject::setSimulationTime(time);
+    for (auto &vehicle : _vehicles)
+    {
+        vehicle->setLaneHandle(LaneHandle());
+    }
+
+    // vehicles are placed on their lanes, those which are crossing an intersection occupy their approach
+    std::unordered_map<int, uint32_t> intersectionIndex;
+    std::vector<std::vector<int>> occupancy(nIntersections);
+    for (uint32_t i = 0; i < nIntersections; ++i)
+    {
+        intersectionIndex[_intersections[i]->getID()] = i;
+        occupancy[i].resize(_intersections[i]->getStreets().size());
+    }
+    for (uint32_t i = 0; i < nStreets; ++i)
+    {
+        std::shared_ptr<Street> &street = _streets[i];
+        street->setModel(static_cast<StreetModel>(models[i]));
+        for (size_t lane = 0; lane < lanes[i].size(); ++lane)
+        {
+            street->setLaneVehicles(static_cast<int>(lane), lanes[i][lane], lastExitTimes[i][lane]);
+
+            std::shared_ptr<Intersection> destination = static_cast<int>(lane) < street->getLanes() ? street->getOutIntersection() : street->getInIntersection();
+            for (size_t k = 0; k < lanes[i][lane].size(); ++k)
+            {
+                const LaneVehicle &laneVehicle = lanes[i][lane][k];
+                LaneHandle handle;
+                handle.lane = static_cast<int>(lane);
+                handle.sequence = k;
+                laneVehicle.vehicle->setCurrentStreet(street);
+                laneVehicle.vehicle->setCurrentDestination(destination);
+                laneVehicle.vehicle->setLaneHandle(handle);
+
+                int approach = destination->getApproach(street);
+                if (laneVehicle.isEntryGranted && approach >= 0)
+                {
+                    ++occupancy[intersectionIndex[destination->getID()]][approach];
+                }
+            }
+        }
+    }
+    for (uint32_t k = 0; k < nWaiting; ++k)
+    {
+        _vehicles[waiting[3 * k]]->setCurrentStreet(_streets[waiting[3 * k + 1]]);
+        _vehicles[waiting[3 * k]]->setCurrentDestination(_intersections[waiting[3 * k + 2]]);
+    }
+
+    for (uint32_t i = 0; i < nIntersections; ++i)
+    {
+        _intersections[i]->restore(throughputs[i], occupancy[i]);
+        _intersections[i]->setSignalPlan(plans[i]);
+        _intersections[i]->getTrafficLight().restorePhase(phaseIndices[i], phaseStarts[i]);
+    }
+
+    return true;
+}
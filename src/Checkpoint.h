@@ -0,0 +1,62 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <memory>
+#include <utility>
+#include <string>
+#include <vector>
+#include "Vehicle.h"
+#include "Street.h"
+#include "Intersection.h"
+
+// saves the state of a whole simulation to a binary file and restores it: the simulation time, the vehicles
+// on every lane with position, speed and entry permission, the vehicles which have not entered a street yet,
+// the throughput of the intersections and the signal plans and phases of their traffic lights. Objects are
+// referred to by their index, so a checkpoint can only be restored into a network which has been built the
+// same way (same builder, parameters and seed). Warmed-up states can then be branched into what-if runs.
+//
+// Vehicles which were waiting for entry or for room on their next street request it again after a restore,
+// so the waiting lines of the intersections and pending platoon releases are rebuilt by the simulation itself.
+// Vehicles which have not entered a street yet are found by their room requests. Those which have not requested
+// room yet are not saved, they still have the street and destination they have been built with.
+class Checkpoint
+{
+public:
+    // constructor / desctructor
+    Checkpoint(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles);
+
+    // typical behaviour methods
+    bool save(const std::string &filename);    // captures a running simulation at a tick boundary, returns false if the file could not be written
+    bool restore(const std::string &filename); // before any object is simulated, returns false if the file does not match the network
+
+private:
+    // state copied while the simulation is held, it is only indexed and encoded after the simulation has continued
+    struct CapturedState
+    {
+        long time;
+        std::vector<long> throughputs, phaseStarts;
+        std::vector<size_t> phaseIndices;
+        std::vector<SignalPlan> plans;
+        std::vector<uint8_t> models;
+        std::vector<long> lastExitTimes;                            // of all lanes of all streets one after the other
+        std::vector<uint32_t> laneSizes;                            // number of vehicles of every lane
+        std::vector<LaneVehicleState> laneVehicles;                 // vehicles of all lanes one after the other
+        std::vector<std::pair<int, int>> roomRequests;              // vehicle id and first lane of the requested direction
+        std::vector<uint32_t> requestStreets;                       // street of every room request
+    };
+
+    // typical behaviour methods
+    void capture(CapturedState &state); // executed on the timing wheel thread, between the callbacks of a tick
+    void encode(const CapturedState &state, std::string &buffer);
+    bool apply(const std::string &buffer);
+
+    // private members
+    static constexpr uint32_t magic = 0x4b435354; // "TSCK"
+    static constexpr uint32_t version = 1;
+
+    std::vector<std::shared_ptr<Street>> _streets;
+    std::vector<std::shared_ptr<Intersection>> _intersections;
+    std::vector<std::shared_ptr<Vehicle>> _vehicles;
+};
+
+#endif
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Logger.h"
+#include "Tracer.h"
+#include "ChunkLog.h"
+
+// size of the fixed part of a chunk: raw size, compressed size, time of the first and the last frame
+static constexpr size_t chunkHeaderSize = 2 * sizeof(uint32_t) + 2 * sizeof(int64_t);
+
+template <typename T>
+static T readValue(const char *data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+/* Implementation of class "ChunkWriter" */
+
+ChunkWriter::ChunkWriter(const std::string &filename, uint32_t magic, uint32_t version, const std::string &header, int nColumns, Counter &bytesWritten)
+    : _bytesCounter(bytesWritten)
+{
+    _magic = magic;
+    _framesPerChunk = 50;
+    _bytesWritten = 0;
+    _columns.resize(nColumns);
+    _chunk = 1;
+    _nFrames = 0;
+    _firstTime = 0;
+    _lastTime = 0;
+
+    _file.open(filename, std::ios::binary);
+    uint32_t fileHeader[3] = {magic, version, static_cast<uint32_t>(header.size())};
+    _file.write(reinterpret_cast<const char *>(fileHeader), sizeof(fileHeader));
+    _file.write(header.data(), header.size());
+    _bytesWritten += sizeof(fileHeader) + header.size();
+}
+
+ChunkWriter::~ChunkWriter()
+{
+    close();
+}
+
+void ChunkWriter::addFrame(long time, uint64_t nRows)
+{
+    if (_nFrames == 0)
+    {
+        _firstTime = time;
+    }
+    _frameHeaders.putSigned(time - _lastTime);
+    _frameHeaders.putUnsigned(nRows);
+    _lastTime = time;
+    if (++_nFrames >= _framesPerChunk)
+    {
+        writeChunk();
+    }
+}
+
+void ChunkWriter::writeChunk()
+{
+    TraceScope trace("writeChunk");
+    if (_nFrames == 0)
+    {
+        return;
+    }
+
+    // chunk header, frame headers and column sizes first, so that a reader can locate every column before decoding
+    ColumnEncoder prefix;
+    prefix.putUnsigned(_nFrames);
+    _raw = prefix.getBytes() + _chunkHeader.getBytes() + _frameHeaders.getBytes();
+    prefix.clear();
+    for (auto &column : _columns)
+    {
+        prefix.putUnsigned(column.getSize());
+    }
+    _raw += prefix.getBytes();
+    for (auto &column : _columns)
+    {
+        _raw += column.getBytes();
+        column.clear();
+    }
+    compressChunk(_raw, _compressed);
+
+    _index.push_back(ChunkIndex{_bytesWritten, _firstTime, _lastTime});
+    uint32_t sizes[2] = {static_cast<uint32_t>(_raw.size()), static_cast<uint32_t>(_compressed.size())};
+    int64_t times[2] = {_firstTime, _lastTime};
+    _file.write(reinterpret_cast<const char *>(sizes), sizeof(sizes));
+    _file.write(reinterpret_cast<const char *>(times), sizeof(times));
+    _file.write(_compressed.data(), _compressed.size());
+    _bytesWritten += chunkHeaderSize + _compressed.size();
+    _bytesCounter.add(chunkHeaderSize + _compressed.size());
+
+    _chunkHeader.clear();
+    _frameHeaders.clear();
+    _nFrames = 0;
+    _lastTime = 0;
+    ++_chunk;
+}
+
+void ChunkWriter::close()
+{
+    if (!_file.is_open())
+    {
+        return;
+    }
+    writeChunk();
+
+    // the index of all chunks lets a reader seek without walking through the file
+    uint32_t footer[2] = {static_cast<uint32_t>(_index.size()), _magic};
+    _file.write(reinterpret_cast<const char *>(_index.data()), _index.size() * sizeof(ChunkIndex));
+    _file.write(reinterpret_cast<const char *>(footer), sizeof(footer));
+    _bytesWritten += _index.size() * sizeof(ChunkIndex) + sizeof(footer);
+    _file.close();
+}
+
+/* Implementation of class "ChunkReader" */
+
+ChunkReader::ChunkReader(const std::string &filename, uint32_t magic, uint32_t version)
+{
+    _data = nullptr;
+    _size = 0;
+
+    // the whole file is mapped, pages are only read from disk once a chunk on them is decoded
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(3 * sizeof(uint32_t)))
+    {
+        Logger::getInstance().log(logError, "ChunkReader: file could not be opened");
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return;
+    }
+    void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        Logger::getInstance().log(logError, "ChunkReader: file could not be mapped");
+        return;
+    }
+    _data = static_cast<const char *>(data);
+    _size = status.st_size;
+
+    if (!readIndex(magic, version))
+    {
+        Logger::getInstance().log(logError, "ChunkReader: file has a different format or version");
+        munmap(const_cast<char *>(_data), _size);
+        _data = nullptr;
+        _size = 0;
+    }
+}
+
+ChunkReader::~ChunkReader()
+{
+    if (_data)
+    {
+        munmap(const_cast<char *>(_data), _size);
+    }
+}
+
+bool ChunkReader::readIndex(uint32_t magic, uint32_t version)
+{
+    uint32_t headerLength = readValue<uint32_t>(_data + 2 * sizeof(uint32_t));
+    if (readValue<uint32_t>(_data) != magic || readValue<uint32_t>(_data + sizeof(uint32_t)) != version ||
+        headerLength > _size - 3 * sizeof(uint32_t))
+    {
+        return false;
+    }
+    _header.assign(_data + 3 * sizeof(uint32_t), headerLength);
+    size_t chunksOffset = 3 * sizeof(uint32_t) + headerLength;
+
+    // a complete file ends with the index of its chunks
+    const size_t footerSize = 2 * sizeof(uint32_t);
+    if (_size - chunksOffset >= footerSize && readValue<uint32_t>(_data + _size - sizeof(uint32_t)) == magic)
+    {
+        uint64_t nChunks = readValue<uint32_t>(_data + _size - footerSize);
+        if (nChunks * sizeof(ChunkIndex) <= _size - chunksOffset - footerSize)
+        {
+            const char *index = _data + _size - footerSize - nChunks * sizeof(ChunkIndex);
+            _index.resize(nChunks);
+            std::memcpy(_index.data(), index, nChunks * sizeof(ChunkIndex));
+            bool isValid = true;
+            for (auto &entry : _index)
+            {
+                isValid = isValid && entry.offset >= chunksOffset && entry.offset <= static_cast<uint64_t>(index - _data) - chunkHeaderSize;
+            }
+            if (isValid)
+            {
+                return true;
+            }
+        }
+    }
+
+    // the recording has been interrupted, the index is rebuilt from the chunk headers up to the first incomplete chunk
+    Logger::getInstance().log(logWarning, "ChunkReader: file has no index, reading the chunk headers");
+    _index.clear();
+    size_t offset = chunksOffset;
+    while (_size - offset >= chunkHeaderSize)
+    {
+        uint32_t compressedSize = readValue<uint32_t>(_data + offset + sizeof(uint32_t));
+        int64_t firstTime = readValue<int64_t>(_data + offset + 2 * sizeof(uint32_t));
+        int64_t lastTime = readValue<int64_t>(_data + offset + 2 * sizeof(uint32_t) + sizeof(int64_t));
+        if (compressedSize == 0 || compressedSize > _size - offset - chunkHeaderSize || firstTime > lastTime ||
+            (!_index.empty() && firstTime <= _index.back().lastTime))
+        {
+            break; // incomplete chunk or the beginning of a partly written index
+        }
+        _index.push_back(ChunkIndex{offset, firstTime, lastTime});
+        offset += chunkHeaderSize + compressedSize;
+    }
+    return true;
+}
+
+bool ChunkReader::readChunk(size_t chunk, std::string &raw)
+{
+    if (chunk >= _index.size())
+    {
+        return false;
+    }
+    const char *data = _data + _index[chunk].offset;
+    uint32_t rawSize = readValue<uint32_t>(data);
+    uint32_t compressedSize = readValue<uint32_t>(data + sizeof(uint32_t));
+
+    return compressedSize <= _size - _index[chunk].offset - chunkHeaderSize && decompressChunk(data + chunkHeaderSize, compressedSize, rawSize, raw);
+}
+
+/* Implementation of struct "ChunkLayout" */
+
+bool ChunkLayout::parse(const std::string &raw, int nColumns, const std::function<bool(ColumnDecoder &header)> &readChunkHeader)
+{
+    ColumnDecoder header(raw.data(), raw.size());
+    uint64_t nFrames = header.getUnsigned();
+    if (nFrames == 0 || nFrames > raw.size() || (readChunkHeader && !readChunkHeader(header)))
+    {
+        return false;
+    }
+    times.resize(nFrames);
+    nRows.resize(nFrames);
+    long time = 0;
+    for (uint64_t f = 0; f < nFrames; ++f)
+    {
+        time += header.getSigned();
+        times[f] = time;
+        nRows[f] = std::min<uint64_t>(header.getUnsigned(), raw.size());
+    }
+
+    // the columns fill the end of the chunk, every column gets a decoder of its own
+    std::vector<uint64_t> columnSizes(nColumns);
+    uint64_t offset = 0;
+    for (auto &size : columnSizes)
+    {
+        size = header.getUnsigned();
+        offset += size;
+    }
+    if (!header.isValid() || offset > raw.size())
+    {
+        return false;
+    }
+    size_t start = raw.size() - offset;
+    columns.resize(nColumns);
+    for (int c = 0; c < nColumns; ++c)
+    {
+        columns[c] = ColumnDecoder(raw.data() + start, columnSizes[c]);
+        start += columnSizes[c];
+    }
+    return true;
+}
@@ -0,0 +1,241 @@
+#ifndef CHUNKLOG_H
+#define CHUNKLOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ColumnCodec.h"
+#include "Metrics.h"
+
+// largest vehicle id accepted by the readers, which protects them from allocating huge tables for corrupt files
+constexpr int maxLogVehicleId = 1 << 28;
+
+// time range and location of a chunk in a chunked log
+struct ChunkIndex
+{
+    uint64_t offset;
+    int64_t firstTime, lastTime;
+};
+
+// previous row of a vehicle in the chunk being encoded or decoded, indexed by vehicle id. Rows are stored as
+// differences to it, a vehicle starts from the default values in every chunk. Base has a member "chunk", which
+// the caller sets to the current chunk once the row has been handled.
+template <typename Base>
+Base &getChunkBase(std::vector<Base> &bases, int id, uint32_t chunk)
+{
+    if (bases.size() <= static_cast<size_t>(id))
+    {
+        bases.resize(id + 1);
+    }
+    Base &base = bases[id];
+    if (base.chunk != chunk)
+    {
+        base = Base();
+    }
+    return base;
+}
+
+// bounded queue which hands the frames of a recorder to its writer thread. Written frames are handed out again,
+// so their arrays are only allocated once. The recording thread never waits: frames which are due while the
+// queue is full are dropped and counted.
+template <class Frame>
+class FrameQueue
+{
+public:
+    // constructor / desctructor
+    FrameQueue(size_t capacity, Counter &droppedFrames);
+
+    // getters / setters
+    uint64_t getDropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+    // typical behaviour methods
+    bool reserve(std::vector<Frame> &frames, size_t nFrames); // takes free frames, returns false if the queue is full or closed
+    void push(Frame &&frame);                                  // queues a frame, which is only kept for reuse once the queue is closed
+    void recycle(Frame &&frame);                               // keeps a frame for reuse
+    bool pop(Frame &frame);                                    // executed in the writer thread, returns false once the queue is closed and empty
+    void close();                                              // frames which have already been queued are still popped
+
+private:
+    size_t _capacity;
+    bool _isOpen;
+    std::deque<Frame> _frames;
+    std::vector<Frame> _freeFrames;
+    std::condition_variable _notEmpty;
+    std::mutex _mutex;
+    std::atomic<uint64_t> _dropped;
+    Counter &_droppedFrames;
+};
+
+// the implementation is in the header, so the queue can be instantiated for any frame type
+template <class Frame>
+FrameQueue<Frame>::FrameQueue(size_t capacity, Counter &droppedFrames) : _droppedFrames(droppedFrames)
+{
+    _capacity = capacity > 0 ? capacity : 1;
+    _isOpen = true;
+    _dropped = 0;
+}
+
+template <class Frame>
+bool FrameQueue<Frame>::reserve(std::vector<Frame> &frames, size_t nFrames)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_isOpen)
+    {
+        return false;
+    }
+    if (_frames.size() >= _capacity)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        _droppedFrames.add();
+        return false;
+    }
+    frames.resize(nFrames);
+    for (auto &frame : frames)
+    {
+        if (!_freeFrames.empty())
+        {
+            frame = std::move(_freeFrames.back());
+            _freeFrames.pop_back();
+        }
+    }
+    return true;
+}
+
+template <class Frame>
+void FrameQueue<Frame>::push(Frame &&frame)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_isOpen)
+    {
+        _frames.push_back(std::move(frame));
+        _notEmpty.notify_one();
+    }
+    else
+    {
+        _freeFrames.push_back(std::move(frame));
+    }
+}
+
+template <class Frame>
+void FrameQueue<Frame>::recycle(Frame &&frame)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _freeFrames.push_back(std::move(frame));
+}
+
+template <class Frame>
+bool FrameQueue<Frame>::pop(Frame &frame)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this] { return !_frames.empty() || !_isOpen; });
+    if (_frames.empty())
+    {
+        return false;
+    }
+    frame = std::move(_frames.front());
+    _frames.pop_front();
+    return true;
+}
+
+template <class Frame>
+void FrameQueue<Frame>::close()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _isOpen = false;
+    _notEmpty.notify_all();
+}
+
+// writes the chunked logs of TrajectoryRecorder and ReplayRecorder. The owner appends the rows of every frame to
+// its columns, consecutive frames are collected into chunks, each of which can be decoded on its own.
+//
+// File layout: magic, version and the length of the header data of the owner (uint32 each) and the header data,
+// followed by the chunks. A chunk is stored as raw size and compressed size (uint32 each), the times of its first
+// and last frame (int64 each) and the zlib compressed data. The data starts with the number of frames, the chunk
+// header of the owner, the time (delta to the previous frame) and row count of every frame and the byte size of
+// every column, the columns follow. The file ends with the index of all chunks (ChunkIndex), their number and the
+// magic again (uint32 each). Values are stored in the byte order of the machine, like checkpoints chunked logs
+// are not meant to be moved between architectures.
+class ChunkWriter
+{
+public:
+    // constructor / desctructor
+    ChunkWriter(const std::string &filename, uint32_t magic, uint32_t version, const std::string &header, int nColumns, Counter &bytesWritten);
+    ~ChunkWriter();
+
+    // getters / setters
+    bool isOpen() { return static_cast<bool>(_file); }
+    void setFramesPerChunk(int nFrames) { _framesPerChunk = nFrames > 0 ? nFrames : 1; }
+    uint64_t getBytesWritten() { return _bytesWritten; }
+    uint32_t getChunk() { return _chunk; }        // number of the current chunk, starting at 1
+    int getFrameCount() { return _nFrames; }      // frames in the current chunk
+    ColumnEncoder &getChunkHeader() { return _chunkHeader; }
+    ColumnEncoder &getColumn(int column) { return _columns[column]; }
+
+    // typical behaviour methods
+    void addFrame(long time, uint64_t nRows); // after the rows of the frame have been appended, writes the chunk once it is full
+    void writeChunk();                        // the next chunk starts without deltas to this one
+    void close();                             // writes the last chunk and the index
+
+private:
+    // private members
+    uint32_t _magic;
+    int _framesPerChunk;
+    std::ofstream _file;
+    std::atomic<uint64_t> _bytesWritten;
+    Counter &_bytesCounter;
+    ColumnEncoder _chunkHeader;
+    ColumnEncoder _frameHeaders;                  // time and row count of every frame of the current chunk
+    std::vector<ColumnEncoder> _columns;
+    std::vector<ChunkIndex> _index;
+    uint32_t _chunk;
+    int _nFrames;
+    int64_t _firstTime, _lastTime;                // of the frames of the current chunk
+    std::string _raw, _compressed;
+};
+
+// reads a chunked log written by ChunkWriter. The file is mapped into memory, so chunks are only read from disk
+// once they are decoded. A recording which has been interrupted has no index, it is rebuilt from the chunk headers.
+class ChunkReader
+{
+public:
+    // constructor / desctructor
+    ChunkReader(const std::string &filename, uint32_t magic, uint32_t version);
+    ~ChunkReader();
+
+    // getters / setters
+    bool isOpen() { return _data != nullptr; }
+    const std::string &getHeader() { return _header; }
+    const std::vector<ChunkIndex> &getIndex() { return _index; }
+
+    // typical behaviour methods
+    bool readChunk(size_t chunk, std::string &raw); // decompresses the chunk, returns false if it is corrupt
+
+private:
+    // typical behaviour methods
+    bool readIndex(uint32_t magic, uint32_t version);
+
+    // private members
+    const char *_data;                            // mapped file, nullptr if it could not be opened
+    size_t _size;
+    std::string _header;
+    std::vector<ChunkIndex> _index;
+};
+
+// frame headers and column decoders of a decompressed chunk
+struct ChunkLayout
+{
+    std::vector<long> times;
+    std::vector<uint64_t> nRows;
+    std::vector<ColumnDecoder> columns;
+
+    // the chunk header of the owner is read by readChunkHeader, returns false if the chunk is corrupt
+    bool parse(const std::string &raw, int nColumns, const std::function<bool(ColumnDecoder &header)> &readChunkHeader = nullptr);
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include <zlib.h>
+#include "ColumnCodec.h"
+
+/* Implementation of class "ColumnDecoder" */
+
+ColumnDecoder::ColumnDecoder(const char *data, size_t size)
+{
+    _data = reinterpret_cast<const uint8_t *>(data);
+    _end = _data + size;
+    _isValid = true;
+}
+
+/* Chunk compression */
+
+void compressChunk(const std::string &raw, std::string &compressed, int level)
+{
+    uLongf size = compressBound(raw.size());
+    compressed.resize(size);
+    compress2(reinterpret_cast<Bytef *>(&compressed[0]), &size, reinterpret_cast<const Bytef *>(raw.data()), raw.size(), level);
+    compressed.resize(size);
+}
+
+bool decompressChunk(const char *data, size_t size, size_t rawSize, std::string &raw)
+{
+    raw.resize(rawSize);
+    uLongf length = rawSize;
+    int result = uncompress(reinterpret_cast<Bytef *>(&raw[0]), &length, reinterpret_cast<const Bytef *>(data), size);
+
+    return result == Z_OK && length == rawSize;
+}
@@ -0,0 +1,87 @@
+#ifndef COLUMNCODEC_H
+#define COLUMNCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// appends integers to a byte column as varints (7 bits per byte, least significant group first). Signed
+// values are zigzag encoded before, so that small deltas of either sign take a single byte.
+class ColumnEncoder
+{
+public:
+    // getters / setters
+    const std::string &getBytes() const { return _bytes; }
+    size_t getSize() const { return _bytes.size(); }
+
+    // typical behaviour methods
+    void clear() { _bytes.clear(); }
+    void putByte(uint8_t value) { _bytes.push_back(static_cast<char>(value)); }
+    void putUnsigned(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            _bytes.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        _bytes.push_back(static_cast<char>(value));
+    }
+    void putSigned(int64_t value) { putUnsigned((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63)); }
+
+private:
+    std::string _bytes;
+};
+
+// reads a column written by ColumnEncoder. Reading beyond the end returns zeros and invalidates the decoder,
+// so corrupt input is detected once after a whole column has been decoded.
+class ColumnDecoder
+{
+public:
+    // constructor / desctructor
+    ColumnDecoder(const char *data = nullptr, size_t size = 0);
+
+    // getters / setters
+    bool isValid() const { return _isValid; }
+    bool isAtEnd() const { return _data == _end; }
+
+    // typical behaviour methods
+    uint8_t getByte()
+    {
+        if (_data == _end)
+        {
+            _isValid = false;
+            return 0;
+        }
+        return *_data++;
+    }
+    uint64_t getUnsigned()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte = getByte();
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return value;
+            }
+        }
+        _isValid = false;
+        return value;
+    }
+    int64_t getSigned()
+    {
+        uint64_t value = getUnsigned();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+private:
+    const uint8_t *_data, *_end;
+    bool _isValid;
+};
+
+// zlib compression of whole chunks. Decompression returns false if the data is corrupt or does not have the expected size.
+void compressChunk(const std::string &raw, std::string &compressed, int level = 1);
+bool decompressChunk(const char *data, size_t size, size_t rawSize, std::string &raw);
+
+#endif
@@ -0,0 +1,34 @@
+#include <algorithm>
+#include "Intersection.h"
+#include "FidelityRegions.h"
+
+/* Implementation of class "FidelityRegions" */
+
+void FidelityRegions::addMicroscopicRegion(double x0, double y0, double x1, double y1)
+{
+    _regions.push_back(Region{std::min(x0, x1), std::min(y0, y1), std::max(x0, x1), std::max(y0, y1)});
+}
+
+bool FidelityRegions::isMicroscopic(double x, double y) const
+{
+    for (auto &region : _regions)
+    {
+        if (x >= region.x0 && x <= region.x1 && y >= region.y0 && y <= region.y1)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void FidelityRegions::apply(std::vector<std::shared_ptr<Street>> &streets) const
+{
+    for (auto &street : streets)
+    {
+        double xIn, yIn, xOut, yOut;
+        street->getInIntersection()->getPosition(xIn, yIn);
+        street->getOutIntersection()->getPosition(xOut, yOut);
+        street->setModel(isMicroscopic(xIn, yIn) || isMicroscopic(xOut, yOut) ? modelMicroscopic : modelMesoscopic);
+    }
+}
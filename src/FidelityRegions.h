@@ -0,0 +1,31 @@
+#ifndef FIDELITYREGIONS_H
+#define FIDELITYREGIONS_H
+
+#include <memory>
+#include <vector>
+#include "Street.h"
+
+// selects the model of every street by region. Streets with at least one end inside a microscopic region are
+// simulated with the car-following model, all others as queues. Vehicles are converted between both models
+// when they move on to the next street, so they keep their entry time and speed at region boundaries.
+class FidelityRegions
+{
+public:
+    // getters / setters
+    void addMicroscopicRegion(double x0, double y0, double x1, double y1); // rectangle in pixels
+    void clearRegions() { _regions.clear(); }
+    bool isMicroscopic(double x, double y) const;
+
+    // typical behaviour methods
+    void apply(std::vector<std::shared_ptr<Street>> &streets) const; // can also be called while the simulation is running
+
+private:
+    struct Region
+    {
+        double x0, y0, x1, y1;
+    };
+
+    std::vector<Region> _regions;
+};
+
+#endif
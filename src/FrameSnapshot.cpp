@@ -0,0 +1,100 @@
+#include "Vehicle.h"
+#include "Intersection.h"
+#include "FrameSnapshot.h"
+#include "Replay.h"
+#include "Tracer.h"
+
+/* Implementation of class "SnapshotBuffer" */
+
+SnapshotBuffer::SnapshotBuffer()
+{
+    _back = 0;
+    _middle = 1;
+    _front = 2;
+}
+
+void SnapshotBuffer::publish()
+{
+    // hand the back buffer over to the consumer and continue with the previous middle buffer
+    uint8_t previous = _middle.exchange(_back | freshBit, std::memory_order_acq_rel);
+    _back = previous & ~freshBit;
+}
+
+bool SnapshotBuffer::consume()
+{
+    if ((_middle.load(std::memory_order_relaxed) & freshBit) == 0)
+    {
+        return false;
+    }
+
+    // take the most recent frame and return the old front buffer to the producer
+    uint8_t previous = _middle.exchange(_front, std::memory_order_acq_rel);
+    _front = previous & ~freshBit;
+    return true;
+}
+
+/* Implementation of class "SnapshotPublisher" */
+
+SnapshotPublisher::SnapshotPublisher()
+{
+    _buffer = std::make_shared<SnapshotBuffer>();
+    _frameNumber = 0;
+}
+
+void SnapshotPublisher::setTrafficObjects(std::vector<std::shared_ptr<Vehicle>> &vehicles, std::vector<std::shared_ptr<Intersection>> &intersections)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _vehicles = vehicles;
+    _intersections = intersections;
+}
+
+void SnapshotPublisher::setRecorder(std::shared_ptr<ReplayRecorder> recorder)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _recorder = recorder;
+}
+
+void SnapshotPublisher::publishFrame(long simulationTime)
+{
+    TraceScope trace("publishFrame");
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    FrameSnapshot &frame = _buffer->getBackBuffer();
+    frame.frameNumber = ++_frameNumber;
+    frame.simulationTime = simulationTime;
+
+    // copy vehicle positions into flat arrays
+    frame.vehicleIds.resize(_vehicles.size());
+    frame.vehicleX.resize(_vehicles.size());
+    frame.vehicleY.resize(_vehicles.size());
+    for (size_t i = 0; i < _vehicles.size(); ++i)
+    {
+        double x, y;
+        _vehicles[i]->getPosition(x, y);
+        frame.vehicleIds[i] = _vehicles[i]->getID();
+        frame.vehicleX[i] = static_cast<float>(x);
+        frame.vehicleY[i] = static_cast<float>(y);
+    }
+
+    // copy intersection positions and traffic light states
+    frame.intersectionIds.resize(_intersections.size());
+    frame.intersectionX.resize(_intersections.size());
+    frame.intersectionY.resize(_intersections.size());
+    frame.lightIsGreen.resize(_intersections.size());
+    for (size_t i = 0; i < _intersections.size(); ++i)
+    {
+        double x, y;
+        _intersections[i]->getPosition(x, y);
+        frame.intersectionIds[i] = _intersections[i]->getID();
+        frame.intersectionX[i] = static_cast<float>(x);
+        frame.intersectionY[i] = static_cast<float>(y);
+        frame.lightIsGreen[i] = _intersections[i]->trafficLightIsGreen() ? 1 : 0;
+    }
+
+    // the recorder copies the frame if one is due, before it is handed over to the consumer
+    if (_recorder)
+    {
+        _recorder->recordFrame(frame);
+    }
+    _buffer->publish();
+}
@@ -0,0 +1,84 @@
+#ifndef FRAMESNAPSHOT_H
+#define FRAMESNAPSHOT_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// forward declarations to avoid include cycle
+class Vehicle;
+class Intersection;
+class ReplayRecorder;
+
+// immutable state of all traffic objects at the end of a simulation tick, stored in flat arrays
+struct FrameSnapshot
+{
+    uint64_t frameNumber = 0;
+    long simulationTime = 0;                  // in ms
+
+    std::vector<int> vehicleIds;
+    std::vector<float> vehicleX, vehicleY;    // in pixels
+
+    std::vector<int> intersectionIds;
+    std::vector<float> intersectionX, intersectionY;
+    std::vector<uint8_t> lightIsGreen;        // 1 if the traffic light shows green on at least one approach
+};
+
+// lock-free triple buffer with a single producer and a single consumer. The producer fills the back buffer
+// and publishes it, the consumer picks up the most recently published frame. Neither side ever waits
+// for the other, and a frame is never modified while the consumer is reading it.
+class SnapshotBuffer
+{
+public:
+    // constructor / desctructor
+    SnapshotBuffer();
+
+    // producer side
+    FrameSnapshot &getBackBuffer() { return _buffers[_back]; }
+    void publish();
+
+    // consumer side
+    bool consume(); // returns true if a new frame has been published since the last call
+    const FrameSnapshot &getFrontBuffer() { return _buffers[_front]; }
+
+private:
+    static constexpr uint8_t freshBit = 0x4;
+
+    std::array<FrameSnapshot, 3> _buffers;
+    std::atomic<uint8_t> _middle;             // index of the buffer exchanged between both sides, plus the fresh flag
+    uint8_t _back;                            // owned by the producer
+    uint8_t _front;                           // owned by the consumer
+};
+
+// copies the state of all vehicles and intersections into a SnapshotBuffer at the end of every step of the
+// StreetScheduler, and optionally into a replay log. Frames are published on the step thread, so every frame holds
+// the positions of a single step and the timing wheel is not held up by the copy.
+class SnapshotPublisher
+{
+public:
+    // constructor / desctructor
+    SnapshotPublisher();
+
+    // getters / setters
+    void setTrafficObjects(std::vector<std::shared_ptr<Vehicle>> &vehicles, std::vector<std::shared_ptr<Intersection>> &intersections);
+    std::shared_ptr<SnapshotBuffer> getSnapshotBuffer() { return _buffer; }
+    void setRecorder(std::shared_ptr<ReplayRecorder> recorder);
+
+    // typical behaviour methods
+    void publishFrame(long simulationTime); // executed by the StreetScheduler once all streets have been updated
+
+private:
+    // private members
+    std::vector<std::shared_ptr<Vehicle>> _vehicles;
+    std::vector<std::shared_ptr<Intersection>> _intersections;
+    std::shared_ptr<SnapshotBuffer> _buffer;
+    std::shared_ptr<ReplayRecorder> _recorder;
+    uint64_t _frameNumber;
+    std::mutex _mutex;
+};
+
+#endif
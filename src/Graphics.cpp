@@ -1,72 +1,454 @@
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include "Graphics.h"
-#include "Intersection.h"
+#include "Logger.h"
+#include "RenderAttributes.h"
+#include "Replay.h"
+#include "SimulationControl.h"
+#include "Tracer.h"
+
+Graphics::Graphics()
+{
+    _nextVideoFrame = -1.0;
+    _replayTime = 0.0;
+    _replaySpeed = 1.0;
+    _isReplayPaused = false;
+    _viewX = -1.0;
+    _viewY = -1.0;
+    _zoom = 1.0;
+    _heatMapZoom = 0.25;
+    _isViewChanged = true;
+    _gridFrame = nullptr;
+    _gridFrameNumber = 0;
+    _gridTime = 0;
+    _tileSize = 128;
+    _renderThreads = std::max(1u, std::thread::hardware_concurrency());
+    _renderPool.setThreads(_renderThreads);
+}
 
 void Graphics::simulate()
 {
+    // create window, unless rendering offscreen
+    _windowName = "Concurrency Traffic Simulation";
+    if (!_encoder)
+    {
+        cv::namedWindow(_windowName, cv::WINDOW_NORMAL);
+    }
+
     this->loadBackgroundImg();
-    while (true)
+    Tracer::getInstance().setThreadName("Graphics");
+    SimulationControl &control = SimulationControl::getInstance();
+    if (_replay)
+    {
+        playReplay();
+    }
+    while (!control.isStopRequested())
     {
         // sleep at every iteration to reduce CPU usage
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
-        // update graphics
-        this->drawTrafficObjects();
+        // update graphics whenever the simulation has published a new frame
+        if (_snapshots->consume())
+        {
+            this->drawTrafficObjects(_snapshots->getFrontBuffer());
+        }
+        else if (!_encoder && control.isPaused())
+        {
+            // no frames are published while paused, keep the window responsive and redraw the last frame if the view has moved
+            handleKey(cv::waitKey(33));
+            if (_isViewChanged)
+            {
+                this->drawTrafficObjects(_snapshots->getFrontBuffer());
+            }
+        }
+    }
+
+    // finish the video file, the window is closed with the program
+    if (_encoder)
+    {
+        _encoder->stop();
     }
 }
 
-void Graphics::loadBackgroundImg()
+void Graphics::setVideoOutput(std::string filename, double fps, cv::Size resolution)
 {
-    // create window
-    _windowName = "Concurrency Traffic Simulation";
-    cv::namedWindow(_windowName, cv::WINDOW_NORMAL);
+    _encoder.reset(new VideoEncoder(filename, fps, resolution));
+    _nextVideoFrame = -1.0; // the video starts with the first rendered frame
+}
 
-    // load image and create copy to be used for semi-transparent overlay
-    cv::Mat background = cv::imread(_bgFilename);
-    _images.push_back(background);         // first element is the original background
-    _images.push_back(background.clone()); // second element will be the transparent overlay
-    _images.push_back(background.clone()); // third element will be the result image for display
+void Graphics::setViewport(double centerX, double centerY, double zoom)
+{
+    _viewX = centerX;
+    _viewY = centerY;
+    _zoom = std::max(zoom, 0.01);
+    _isViewChanged = true;
 }
 
-void Graphics::drawTrafficObjects()
+void Graphics::loadBackgroundImg()
 {
-    // reset images
-    _images.at(1) = _images.at(0).clone();
-    _images.at(2) = _images.at(0).clone();
+    // load image, by default the whole map is shown at its original size
+    _map = cv::imread(_bgFilename);
+    if (_viewSize.empty())
+    {
+        _viewSize = _map.size();
+    }
+    if (_viewX < 0.0 || _viewY < 0.0)
+    {
+        _viewX = _map.cols / 2.0;
+        _viewY = _map.rows / 2.0;
+    }
+    _vehicleGrid.setBounds(_map.cols, _map.rows);
+    _intersectionGrid.setBounds(_map.cols, _map.rows);
+    _gridFrame = nullptr;
+    _isViewChanged = true;
+}
 
-    // create overlay from all traffic objects
-    for (auto it : _trafficObjects)
+void Graphics::updateViewBackground()
+{
+    // scale the visible part of the map to the view, areas outside of the map stay black
+    double left = _viewX - _viewSize.width / (2.0 * _zoom);
+    double top = _viewY - _viewSize.height / (2.0 * _zoom);
+    cv::Mat background(_viewSize, _map.type(), cv::Scalar(0, 0, 0));
+    cv::Rect mapRect = cv::Rect(static_cast<int>(std::floor(left)), static_cast<int>(std::floor(top)),
+                                static_cast<int>(std::ceil(_viewSize.width / _zoom)) + 1, static_cast<int>(std::ceil(_viewSize.height / _zoom)) + 1) &
+                       cv::Rect(0, 0, _map.cols, _map.rows);
+    if (!mapRect.empty())
     {
-        double posx, posy;
-        it->getPosition(posx, posy);
+        cv::Rect viewRect = cv::Rect(static_cast<int>((mapRect.x - left) * _zoom), static_cast<int>((mapRect.y - top) * _zoom),
+                                     std::max(1, static_cast<int>(mapRect.width * _zoom)), std::max(1, static_cast<int>(mapRect.height * _zoom))) &
+                            cv::Rect(0, 0, _viewSize.width, _viewSize.height);
+        if (!viewRect.empty())
+        {
+            cv::Mat target = background(viewRect);
+            cv::resize(_map(mapRect), target, viewRect.size(), 0, 0, cv::INTER_AREA);
+        }
+    }
+
+    // background, overlay and display image of the viewport
+    _images.clear();
+    _images.push_back(background);
+    _images.push_back(background.clone());
+    _images.push_back(background.clone());
+    _drawnTiles.clear();
+    _isViewChanged = false;
+}
+
+void Graphics::drawTrafficObjects(const FrameSnapshot &frame)
+{
+    renderFrame(frame);
+    presentFrame(frame.simulationTime);
+}
 
-        if (it->getType() == ObjectType::objectIntersection)
+void Graphics::binObject(double x, double y, int radius, uint32_t index, std::vector<std::vector<uint32_t>> &bins)
+{
+    // add the object to every tile overlapped by the bounding box of its circle
+    int tileCols = (_viewSize.width + _tileSize - 1) / _tileSize;
+    int tileRows = (_viewSize.height + _tileSize - 1) / _tileSize;
+    int col0 = std::max(0, (static_cast<int>(x) - radius - 1) / _tileSize), col1 = std::min(tileCols - 1, (static_cast<int>(x) + radius + 1) / _tileSize);
+    int row0 = std::max(0, (static_cast<int>(y) - radius - 1) / _tileSize), row1 = std::min(tileRows - 1, (static_cast<int>(y) + radius + 1) / _tileSize);
+    for (int row = row0; row <= row1; ++row)
+    {
+        for (int col = col0; col <= col1; ++col)
         {
-            // cast object type from TrafficObject to Intersection
-            std::shared_ptr<Intersection> intersection = std::dynamic_pointer_cast<Intersection>(it);
+            bins[row * tileCols + col].push_back(index);
+        }
+    }
+}
+
+const cv::Mat &Graphics::renderFrame(const FrameSnapshot &frame)
+{
+    TraceScope trace("renderFrame");
+    if (_isViewChanged)
+    {
+        updateViewBackground();
+    }
 
-            // set color according to traffic light and draw the intersection as a circle
-            cv::Scalar trafficLightColor = intersection->trafficLightIsGreen() == true ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 0, 255);
-            cv::circle(_images.at(1), cv::Point2d(posx, posy), 25, trafficLightColor, -1);
+    // index all objects so that only those inside the viewport are visited. The index only depends on the frame,
+    // not on the view, so it is kept while the same frame is redrawn (paused, panned or zoomed)
+    if (&frame != _gridFrame || frame.frameNumber != _gridFrameNumber || frame.simulationTime != _gridTime)
+    {
+        _vehicleGrid.build(frame.vehicleX, frame.vehicleY, _renderThreads);
+        _intersectionGrid.build(frame.intersectionX, frame.intersectionY);
+        _gridFrame = &frame;
+        _gridFrameNumber = frame.frameNumber;
+        _gridTime = frame.simulationTime;
+    }
+
+    // visible part of the map, enlarged by the largest object radius
+    double left = _viewX - _viewSize.width / (2.0 * _zoom);
+    double top = _viewY - _viewSize.height / (2.0 * _zoom);
+    double right = left + _viewSize.width / _zoom;
+    double bottom = top + _viewSize.height / _zoom;
+    bool isHeatMap = _zoom < _heatMapZoom;
+    int intersectionRadius = std::max(1, static_cast<int>(25 * _zoom));
+
+    // bin all visible objects into the tiles of the view
+    size_t nTiles = static_cast<size_t>((_viewSize.width + _tileSize - 1) / _tileSize) * ((_viewSize.height + _tileSize - 1) / _tileSize);
+    _tileIntersections.resize(nTiles);
+    _tileVehicles.resize(nTiles);
+    for (size_t tile = 0; tile < nTiles; ++tile)
+    {
+        _tileIntersections[tile].clear();
+        _tileVehicles[tile].clear();
+    }
+    _intersectionGrid.queryRect(left - 25, top - 25, right + 25, bottom + 25, _visible);
+    for (auto i : _visible)
+    {
+        binObject((frame.intersectionX[i] - left) * _zoom, (frame.intersectionY[i] - top) * _zoom, intersectionRadius, i, _tileIntersections);
+    }
+    if (!isHeatMap)
+    {
+        const RenderAttributeTable &attributes = RenderAttributeTable::getInstance();
+        double margin = attributes.getMaxRadius();
+        _vehicleGrid.queryRect(left - margin, top - margin, right + margin, bottom + margin, _visible);
+        for (auto i : _visible)
+        {
+            int vehicleRadius = std::max(1, static_cast<int>(attributes.get(frame.vehicleIds[i]).radius * _zoom));
+            binObject((frame.vehicleX[i] - left) * _zoom, (frame.vehicleY[i] - top) * _zoom, vehicleRadius, i, _tileVehicles);
         }
-        else if (it->getType() == ObjectType::objectVehicle)
+    }
+
+    // a tile has to be redrawn if it contains objects now or has contained objects in the previous frame
+    std::vector<uint8_t> drawnTiles(nTiles, 0);
+    std::vector<size_t> dirtyTiles;
+    _drawnTiles.resize(nTiles, 0);
+    for (size_t tile = 0; tile < nTiles; ++tile)
+    {
+        drawnTiles[tile] = isHeatMap || !_tileIntersections[tile].empty() || !_tileVehicles[tile].empty();
+        if (drawnTiles[tile] || _drawnTiles[tile])
         {
-            cv::RNG rng(it->getID());
-            int b = rng.uniform(0, 255);
-            int g = rng.uniform(0, 255);
-            int r = sqrt(255*255 - g*g - r*r); // ensure that length of color vector is always 255
-            cv::Scalar vehicleColor = cv::Scalar(b,g,r);
-            cv::circle(_images.at(1), cv::Point2d(posx, posy), 50, vehicleColor, -1);
+            dirtyTiles.push_back(tile);
         }
     }
+    _drawnTiles = std::move(drawnTiles);
+
+    // rasterize the dirty tiles on the persistent render threads, tiles never overlap so every task writes to its own pixels
+    _renderPool.run(dirtyTiles.size(), [&](size_t k) { rasterizeTile(dirtyTiles[k], frame, left, top, isHeatMap); });
 
+    return _images.at(2);
+}
+
+void Graphics::rasterizeTile(size_t tile, const FrameSnapshot &frame, double left, double top, bool isHeatMap)
+{
+    int tileCols = (_viewSize.width + _tileSize - 1) / _tileSize;
+    cv::Rect rect = cv::Rect(static_cast<int>(tile % tileCols) * _tileSize, static_cast<int>(tile / tileCols) * _tileSize, _tileSize, _tileSize) &
+                    cv::Rect(0, 0, _viewSize.width, _viewSize.height);
+    cv::Mat background = _images.at(0)(rect);
+    cv::Mat overlay = _images.at(1)(rect);
+    cv::Mat display = _images.at(2)(rect);
+
+    // a tile without objects is identical to the background
+    if (!isHeatMap && _tileIntersections[tile].empty() && _tileVehicles[tile].empty())
+    {
+        background.copyTo(display);
+        return;
+    }
+    background.copyTo(overlay);
+
+    // zoomed out, vehicles are aggregated into density tiles
+    if (isHeatMap)
+    {
+        drawHeatTiles(overlay, rect, left, top);
+    }
+
+    // create overlay from all intersections in this tile, colored according to their traffic light
+    int intersectionRadius = std::max(1, static_cast<int>(25 * _zoom));
+    for (auto i : _tileIntersections[tile])
+    {
+        cv::Scalar trafficLightColor = frame.lightIsGreen[i] ? cv::Scalar(0, 255, 0) : cv::Scalar(0, 0, 255);
+        cv::Point center(static_cast<int>((frame.intersectionX[i] - left) * _zoom) - rect.x, static_cast<int>((frame.intersectionY[i] - top) * _zoom) - rect.y);
+        cv::circle(overlay, center, intersectionRadius, trafficLightColor, -1);
+    }
+
+    // add all vehicles in this tile to the overlay, using the attributes assigned when they were created
+    const RenderAttributeTable &attributes = RenderAttributeTable::getInstance();
+    for (auto i : _tileVehicles[tile])
+    {
+        const RenderAttributes &vehicle = attributes.get(frame.vehicleIds[i]);
+        cv::Scalar vehicleColor = cv::Scalar(vehicle.blue, vehicle.green, vehicle.red);
+        int vehicleRadius = std::max(1, static_cast<int>(vehicle.radius * _zoom));
+        cv::Point center(static_cast<int>((frame.vehicleX[i] - left) * _zoom) - rect.x, static_cast<int>((frame.vehicleY[i] - top) * _zoom) - rect.y);
+        cv::circle(overlay, center, vehicleRadius, vehicleColor, -1);
+    }
+
+    // blend the overlay with the cached background
     float opacity = 0.85;
-    cv::addWeighted(_images.at(1), opacity, _images.at(0), 1.0 - opacity, 0, _images.at(2));
+    cv::addWeighted(overlay, opacity, background, 1.0 - opacity, 0, display);
+}
+
+void Graphics::drawHeatTiles(cv::Mat &overlay, cv::Rect rect, double left, double top)
+{
+    // every grid cell overlapping the tile is colored from green to red according to the number of vehicles in it
+    float cellSize = _vehicleGrid.getCellSize();
+    double x0 = left + rect.x / _zoom, x1 = left + (rect.x + rect.width) / _zoom;
+    double y0 = top + rect.y / _zoom, y1 = top + (rect.y + rect.height) / _zoom;
+    int col0 = std::max(0, static_cast<int>(x0 / cellSize)), col1 = std::min(_vehicleGrid.getColumns() - 1, static_cast<int>(x1 / cellSize));
+    int row0 = std::max(0, static_cast<int>(y0 / cellSize)), row1 = std::min(_vehicleGrid.getRows() - 1, static_cast<int>(y1 / cellSize));
+    for (int row = row0; row <= row1; ++row)
+    {
+        for (int col = col0; col <= col1; ++col)
+        {
+            int count = _vehicleGrid.getCellCount(col, row);
+            if (count == 0)
+            {
+                continue;
+            }
+            double density = std::min(1.0, count / 10.0);
+            cv::Rect cell(static_cast<int>((col * cellSize - left) * _zoom) - rect.x, static_cast<int>((row * cellSize - top) * _zoom) - rect.y,
+                          std::max(1, static_cast<int>(std::ceil(cellSize * _zoom))), std::max(1, static_cast<int>(std::ceil(cellSize * _zoom))));
+            cv::rectangle(overlay, cell, cv::Scalar(0, 255 * (1.0 - density), 255 * density), -1);
+        }
+    }
+}
 
-    // display background and overlay image
-    cv::imshow(_windowName, _images.at(2));
-    cv::waitKey(33);
+void Graphics::playReplay()
+{
+    // the playback position advances with the elapsed wall time times the speed, in a video by one frame interval
+    // per frame. Only the chunks around the position are decoded
+    SimulationControl &control = SimulationControl::getInstance();
+    _replayTime = _replay->getStartTime();
+    double videoTime = 0.0;
+    FrameSnapshot frame;
+    auto last = std::chrono::steady_clock::now();
+    while (!control.isStopRequested())
+    {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = _encoder ? 1000.0 / _encoder->getFps() : std::chrono::duration<double, std::milli>(now - last).count();
+        last = now;
+        if (!_isReplayPaused)
+        {
+            _replayTime += elapsed * _replaySpeed;
+        }
+        _replayTime = std::max<double>(_replay->getStartTime(), std::min<double>(_replay->getEndTime(), _replayTime));
+        if (!_replay->getFrame(static_cast<long>(_replayTime), frame))
+        {
+            Logger::getInstance().log(logError, "Graphics: replay log is corrupt at %ld ms", static_cast<long>(_replayTime));
+            control.requestStop();
+            break;
+        }
+        renderFrame(frame);
+        presentFrame(static_cast<long>(std::ceil(videoTime)));
+        videoTime += elapsed;
+
+        // a video ends with the recording, a window stays open at its last frame
+        if (_encoder && _replayTime >= _replay->getEndTime())
+        {
+            control.requestStop();
+        }
+    }
+}
+
+bool Graphics::handleReplayKey(int key)
+{
+    // pause and resume with space, advance by 100 ms with n, seek by 10 s with j/l and back to the start with 0.
+    // f plays forward and doubles the speed with every further press, b does the same in reverse
+    switch (key)
+    {
+    case ' ':
+        _isReplayPaused = !_isReplayPaused;
+        return true;
+    case 'n':
+        _isReplayPaused = true;
+        _replayTime += 100.0;
+        return true;
+    case 'j':
+        _replayTime -= 10000.0;
+        return true;
+    case 'l':
+        _replayTime += 10000.0;
+        return true;
+    case '0':
+        _replayTime = _replay->getStartTime();
+        return true;
+    case 'f':
+        _replaySpeed = _replaySpeed >= 1.0 ? std::min(2.0 * _replaySpeed, 64.0) : 1.0;
+        _isReplayPaused = false;
+        return true;
+    case 'b':
+        _replaySpeed = _replaySpeed <= -1.0 ? std::max(2.0 * _replaySpeed, -64.0) : -1.0;
+        _isReplayPaused = false;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void Graphics::handleKey(int key)
+{
+    if (_replay && handleReplayKey(key))
+    {
+        return;
+    }
+
+    // pan with w/a/s/d by a quarter of the view, zoom with +/-, reset with r.
+    // Pause and resume with space, advance a paused simulation by 100 ms with n, quit with q or escape
+    double panX = _viewSize.width / (4.0 * _zoom), panY = _viewSize.height / (4.0 * _zoom);
+    switch (key)
+    {
+    case 'w':
+        setViewport(_viewX, _viewY - panY, _zoom);
+        break;
+    case 's':
+        setViewport(_viewX, _viewY + panY, _zoom);
+        break;
+    case 'a':
+        setViewport(_viewX - panX, _viewY, _zoom);
+        break;
+    case 'd':
+        setViewport(_viewX + panX, _viewY, _zoom);
+        break;
+    case '+':
+        setViewport(_viewX, _viewY, _zoom * 1.5);
+        break;
+    case '-':
+        setViewport(_viewX, _viewY, _zoom / 1.5);
+        break;
+    case 'r':
+        setViewport(_map.cols / 2.0, _map.rows / 2.0, std::min(_viewSize.width / double(_map.cols), _viewSize.height / double(_map.rows)));
+        break;
+    case ' ':
+        if (SimulationControl::getInstance().isPaused())
+            SimulationControl::getInstance().resume();
+        else
+            SimulationControl::getInstance().pause();
+        break;
+    case 'n':
+        SimulationControl::getInstance().step(100);
+        break;
+    case 'q':
+    case 27:
+        SimulationControl::getInstance().requestStop();
+        break;
+    default:
+        break;
+    }
+}
+
+void Graphics::presentFrame(long simulationTime)
+{
+    TraceScope trace("presentFrame");
+    if (!_encoder)
+    {
+        // display background and overlay image
+        cv::imshow(_windowName, _images.at(2));
+        handleKey(cv::waitKey(33));
+        return;
+    }
+
+    // emit video frames at a fixed rate in simulation time, repeating the image if the simulation has advanced further
+    if (_nextVideoFrame < 0.0)
+    {
+        _nextVideoFrame = simulationTime;
+    }
+    while (_nextVideoFrame <= simulationTime)
+    {
+        _encoder->pushFrame(_images.at(2));
+        _nextVideoFrame += 1000.0 / _encoder->getFps();
+    }
 }
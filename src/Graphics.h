@@ -3,31 +3,83 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <opencv2/core.hpp>
-#include "TrafficObject.h"
+#include "FrameSnapshot.h"
+#include "SpatialGrid.h"
+#include "VideoEncoder.h"
+#include "WorkerPool.h"
+
+// forward declarations to avoid include cycle
+class ReplayReader;
 
 class Graphics
 {
 public:
     // constructor / desctructor
+    Graphics();
 
     // getters / setters
     void setBgFilename(std::string filename) { _bgFilename = filename; }
-    void setTrafficObjects(std::vector<std::shared_ptr<TrafficObject>> &trafficObjects) { _trafficObjects = trafficObjects; };
+    void setSnapshotBuffer(std::shared_ptr<SnapshotBuffer> snapshots) { _snapshots = snapshots; };
+    void setReplay(std::shared_ptr<ReplayReader> replay) { _replay = replay; } // plays back a replay log instead of the frames of the simulation
+    void setVideoOutput(std::string filename, double fps, cv::Size resolution = cv::Size()); // render offscreen into a video file
+    void setViewport(double centerX, double centerY, double zoom); // map position in the center of the view, view pixels per map pixel
+    void setViewSize(cv::Size viewSize) { _viewSize = viewSize; _isViewChanged = true; }
+    void setHeatMapZoom(double zoom) { _heatMapZoom = zoom; } // below this zoom, vehicles are aggregated into density tiles
+    void setRenderThreads(int nThreads) { _renderThreads = nThreads > 0 ? nThreads : 1; _renderPool.setThreads(_renderThreads); }
+    void setTileSize(int tileSize) { _tileSize = tileSize > 0 ? tileSize : 128; _isViewChanged = true; }
 
     // typical behaviour methods
     void simulate();
+    void loadBackgroundImg();
+    const cv::Mat &renderFrame(const FrameSnapshot &frame); // renders a frame into the display image without presenting it
 
 private:
     // typical behaviour methods
-    void loadBackgroundImg();
-    void drawTrafficObjects();
+    void updateViewBackground();
+    void drawTrafficObjects(const FrameSnapshot &frame);
+    void binObject(double x, double y, int radius, uint32_t index, std::vector<std::vector<uint32_t>> &bins);
+    void rasterizeTile(size_t tile, const FrameSnapshot &frame, double left, double top, bool isHeatMap);
+    void drawHeatTiles(cv::Mat &overlay, cv::Rect rect, double left, double top);
+    void presentFrame(long simulationTime);
+    void playReplay();
+    void handleKey(int key);
+    bool handleReplayKey(int key); // returns false if the key does not control the playback
 
     // member variables
-    std::vector<std::shared_ptr<TrafficObject>> _trafficObjects;
+    std::shared_ptr<SnapshotBuffer> _snapshots; // frames published by the simulation, consumed without locking
     std::string _bgFilename;
     std::string _windowName;
-    std::vector<cv::Mat> _images;
+    cv::Mat _map;                      // full background map
+    std::vector<cv::Mat> _images;      // background, overlay and display image of the current viewport
+    std::unique_ptr<VideoEncoder> _encoder; // set in offscreen mode, no window is opened then
+    double _nextVideoFrame;                 // simulation time of the next video frame in ms
+
+    // playback of a replay log
+    std::shared_ptr<ReplayReader> _replay;
+    double _replayTime;                // position in the recorded simulation time in ms
+    double _replaySpeed;               // recorded time per wall time, negative in reverse
+    bool _isReplayPaused;
+
+    // viewport
+    double _viewX, _viewY;             // map position in the center of the view in pixels, negative until initialized
+    double _zoom;                      // view pixels per map pixel
+    double _heatMapZoom;
+    cv::Size _viewSize;                // size of the rendered image, the map size unless set explicitly
+    bool _isViewChanged;               // view background has to be rebuilt before the next frame
+    SpatialGrid _vehicleGrid, _intersectionGrid; // used to cull objects outside of the viewport
+    const FrameSnapshot *_gridFrame;   // frame the grids have been built for, they are kept while it is redrawn
+    uint64_t _gridFrameNumber;
+    long _gridTime;
+    std::vector<uint32_t> _visible;    // scratch buffer for grid queries
+
+    // tiled rasterization
+    int _tileSize;                     // edge length of a square render tile in view pixels
+    int _renderThreads;                // number of threads rasterizing tiles in parallel
+    WorkerPool _renderPool;            // started with the first frame, kept for all following ones
+    std::vector<std::vector<uint32_t>> _tileIntersections, _tileVehicles; // objects overlapping every tile
+    std::vector<uint8_t> _drawnTiles;  // tiles which contained objects in the previous frame
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -3,24 +3,41 @@
 #include <chrono>
 #include <future>
 #include <random>
+#include <algorithm>
 
 #include "Street.h"
 #include "Intersection.h"
 #include "Vehicle.h"
+#include "Metrics.h"
+#include "Logger.h"
+#include "Tracer.h"
 
 /* Implementation of class "WaitingVehicles" */
 
+WaitingVehicles::WaitingVehicles()
+{
+    _nextRelease = 0;
+    _isReleased = false;
+}
+
 int WaitingVehicles::getSize()
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+    lockWithTrace(lock, "WaitingVehicles::_mutex");
 
     return _vehicles.size();
 }
 
 void WaitingVehicles::pushBack(std::shared_ptr<Vehicle> vehicle, std::promise<void> &&promise)
 {
-    std::lock_guard<std::mutex> lock(_mutex);
+    std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+    lockWithTrace(lock, "WaitingVehicles::_mutex");
 
+    if (_isReleased)
+    {
+        promise.set_value();
+        return;
+    }
     _vehicles.push_back(vehicle);
     _promises.push_back(std::move(promise));
 }
@@ -41,17 +58,167 @@ void WaitingVehicles::permitEntryToFirstInQueue()
     _promises.erase(firstPromise);
 }
 
+size_t WaitingVehicles::permitEntryToPlatoon(size_t nVehicles, int lanes, long headway)
+{
+    std::unique_lock<std::mutex> lock(_mutex, std::defer_lock);
+    lockWithTrace(lock, "WaitingVehicles::_mutex");
+
+    nVehicles = std::min(nVehicles, _vehicles.size());
+    long now = TrafficObject::getSimulationTime();
+    for (size_t k = 0; k < nVehicles; ++k)
+    {
+        // consecutive vehicles keep the headway, spread over all lanes of the approach (saturation flow)
+        long releaseTime = std::max(now, _nextRelease);
+        _nextRelease = releaseTime + headway / std::max(lanes, 1);
+        if (releaseTime <= now)
+        {
+            _promises[k].set_value();
+        }
+        else
+        {
+            auto entry = std::make_shared<ScheduledEntry>();
+            entry->promise = std::move(_promises[k]);
+            TrafficObject::getTimingWheel().schedule(releaseTime - now, [entry]() { entry->grant(); });
+            _scheduledEntries.push_back(entry);
+        }
+    }
+    _scheduledEntries.erase(std::remove_if(_scheduledEntries.begin(), _scheduledEntries.end(),
+                                           [](const std::shared_ptr<ScheduledEntry> &entry) { return entry->isGranted.load(); }),
+                            _scheduledEntries.end());
+
+    // remove the whole platoon from both queues at once
+    _vehicles.erase(_vehicles.begin(), _vehicles.begin() + nVehicles);
+    _promises.erase(_promises.begin(), _promises.begin() + nVehicles);
+
+    return nVehicles;
+}
+
+void WaitingVehicles::releaseAll()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _isReleased = true;
+    for (auto &promise : _promises)
+    {
+        promise.set_value();
+    }
+    for (auto &entry : _scheduledEntries)
+    {
+        entry->grant();
+    }
+    _vehicles.clear();
+    _promises.clear();
+    _scheduledEntries.clear();
+}
+
 /* Implementation of class "Intersection" */
 
-Intersection::Intersection()
+Intersection::Intersection(int id) : TrafficObject(id)
 {
     _type = ObjectType::objectIntersection;
-    _isBlocked = false;
+    _nextApproach = 0;
+    _maxPlatoonSize = 4;
+    _headway = 200;
+    _vehiclesPassed = 0;
+}
+
+void Intersection::setPlatoonParameters(int maxPlatoonSize, long headway)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _maxPlatoonSize = std::max(maxPlatoonSize, 1);
+    _headway = std::max(headway, 0L);
+}
+
+void Intersection::restore(long vehiclesPassed, const std::vector<int> &occupancy)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // vehicles which are crossing count against the platoon size of their approach until they have left
+    _vehiclesPassed = vehiclesPassed;
+    for (size_t approach = 0; approach < _occupancy.size() && approach < occupancy.size(); ++approach)
+    {
+        _occupancy[approach] = occupancy[approach];
+    }
 }
 
 void Intersection::addStreet(std::shared_ptr<Street> street)
 {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // green and compatibility masks hold one bit per approach
+    if (_streets.size() >= maxApproaches)
+    {
+        Logger::getInstance().log(logError, "Intersection #%ld: street #%ld exceeds %ld approaches and is ignored",
+                                  _id, street->getID(), static_cast<long>(maxApproaches));
+        return;
+    }
+
+    // every street is an approach with its own waiting line, which by default only is compatible with itself
     _streets.push_back(street);
+    _waitingVehicles.emplace_back(new WaitingVehicles());
+    _occupancy.push_back(0);
+    _compatible.push_back(uint64_t(1) << _compatible.size());
+    _queueLengths.push_back(0);
+    _arrivals.push_back(0);
+}
+
+void Intersection::clearStreets()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    _streets.clear();
+    _waitingVehicles.clear();
+    _occupancy.clear();
+    _compatible.clear();
+    _queueLengths.clear();
+    _arrivals.clear();
+    _nextApproach = 0;
+}
+
+void Intersection::setCompatibleApproaches(uint64_t movementSet)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (size_t approach = 0; approach < _compatible.size(); ++approach)
+    {
+        if (movementSet & (uint64_t(1) << approach))
+        {
+            _compatible[approach] |= movementSet;
+        }
+    }
+}
+
+void Intersection::setMovementSetsFromSignalPlan()
+{
+    // approaches which share a green phase have been designed not to conflict
+    SignalPlan plan = _trafficLight.getSignalPlan();
+    for (size_t phase = 0; phase < plan.getPhaseCount(); ++phase)
+    {
+        setCompatibleApproaches(plan.getPhase(phase).greenMask);
+    }
+}
+
+void Intersection::getApproachCounts(std::vector<long> &queueLengths, std::vector<long> &arrivals)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    queueLengths = _queueLengths;
+    arrivals = _arrivals;
+    std::fill(_arrivals.begin(), _arrivals.end(), 0);
+}
+
+int Intersection::getApproach(std::shared_ptr<Street> street)
+{
+    for (size_t i = 0; i < _streets.size(); ++i)
+    {
+        if (_streets[i]->getID() == street->getID())
+        {
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
 }
 
 std::vector<std::shared_ptr<Street>> Intersection::queryStreets(std::shared_ptr<Street> incoming)
@@ -72,45 +239,62 @@ std::vector<std::shared_ptr<Street>> Intersection::queryStreets(std::shared_ptr<
 // adds a new vehicle to the queue and returns once the vehicle is allowed to enter
 void Intersection::addVehicleToQueue(std::shared_ptr<Vehicle> vehicle)
 {
-    TrafficLightPhase curr_phase{};
+    Logger::getInstance().log(logDebug, "Intersection #%ld::addVehicleToQueue: vehicle #%ld", _id, vehicle->getID());
+
+    static Histogram &waitTime = MetricsRegistry::getInstance().getHistogram("intersection.wait_ms");
+    static Gauge &queueDepth = MetricsRegistry::getInstance().getGauge("intersection.queue_depth");
+    static Counter &vehiclesPassed = MetricsRegistry::getInstance().getCounter("intersection.vehicles_passed");
 
-    std::unique_lock<std::mutex> lck(_mtx);
-    std::cout << "Intersection #" << _id << "::addVehicleToQueue: thread id = " << std::this_thread::get_id() << std::endl;
-    lck.unlock();
+    // count the vehicle on its approach until it has been admitted
+    int approach = getApproach(vehicle->getCurrentStreet());
+    if (approach < 0)
+    {
+        Logger::getInstance().log(logWarning, "Intersection #%ld: vehicle #%ld arrives on street #%ld, which is not an approach",
+                                  _id, vehicle->getID(), vehicle->getCurrentStreet()->getID());
+        return;
+    }
+    long arrivalTime = getSimulationTime();
+    queueDepth.add(1);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_queueLengths[approach];
+        ++_arrivals[approach];
+    }
 
-    // add new vehicle to the end of the waiting line
+    // add new vehicle to the end of the waiting line of its approach
     std::promise<void> prmsVehicleAllowedToEnter;
     std::future<void> ftrVehicleAllowedToEnter = prmsVehicleAllowedToEnter.get_future();
-    _waitingVehicles.pushBack(vehicle, std::move(prmsVehicleAllowedToEnter));
+    _waitingVehicles[approach]->pushBack(vehicle, std::move(prmsVehicleAllowedToEnter));
 
     // wait until the vehicle is allowed to enter
     ftrVehicleAllowedToEnter.wait();
-    lck.lock();
-    std::cout << "Intersection #" << _id << ": Vehicle #" << vehicle->getID() << " is granted entry." << std::endl;
-    lck.unlock();
+    Logger::getInstance().log(logDebug, "Intersection #%ld: Vehicle #%ld is granted entry.", _id, vehicle->getID());
     
-    // FP.6b : use the methods TrafficLight::getCurrentPhase and TrafficLight::waitForGreen to block the execution until the traffic light turns green.
-    // Get the current phase of the traffic light
-    curr_phase = _trafficLight.getCurrentPhase();
-
-    // Block this code's execution until traffic light turns green
-    if (curr_phase == red) {
-        _trafficLight.waitForGreen();
+    // FP.6b : vehicles are only admitted while their approach is green (see admitVehicles),
+    // so there is no need to wait for the traffic light once entry has been granted.
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        --_queueLengths[approach];
     }
+    ++_vehiclesPassed;
+    queueDepth.add(-1);
+    vehiclesPassed.add();
+    waitTime.record(getSimulationTime() - arrivalTime);
 }
 
 void Intersection::vehicleHasLeft(std::shared_ptr<Vehicle> vehicle)
 {
     //std::cout << "Intersection #" << _id << ": Vehicle #" << vehicle->getID() << " has left." << std::endl;
 
-    // unblock queue processing
-    this->setIsBlocked(false);
-}
-
-void Intersection::setIsBlocked(bool isBlocked)
-{
-    _isBlocked = isBlocked;
-    //std::cout << "Intersection #" << _id << " isBlocked=" << isBlocked << std::endl;
+    // free the lane the vehicle has been using on its approach
+    // vehicles on a street which is not an approach have not been admitted, see addVehicleToQueue
+    int approach = getApproach(vehicle->getCurrentStreet());
+    if (approach < 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    --_occupancy[approach];
 }
 
 // virtual function which is executed in a thread
@@ -120,41 +304,84 @@ void Intersection::simulate() // using threads + promises/futures + exceptions
     _trafficLight.simulate();
 
     // launch vehicle queue processing in a thread
-    threads.emplace_back(std::thread(&Intersection::processVehicleQueue, this));
+    _threads.emplace_back(std::thread(&Intersection::processVehicleQueue, this));
+}
+
+void Intersection::stop()
+{
+    _isStopping = true;
+    _trafficLight.stop();
+
+    // vehicles waiting for entry are released, so that their threads can finish as well
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &waitingVehicles : _waitingVehicles)
+        {
+            waitingVehicles->releaseAll();
+        }
+    }
+    joinThreads();
 }
 
 void Intersection::processVehicleQueue()
 {
     // print id of the current thread
     //std::cout << "Intersection #" << _id << "::processVehicleQueue: thread id = " << std::this_thread::get_id() << std::endl;
+    Tracer::getInstance().setThreadName("Intersection #" + std::to_string(_id));
 
-    // continuously process the vehicle queue
-    while (true)
+    // continuously process the vehicle queue until the intersection is stopped
+    while (!_isStopping)
     {
         // sleep at every iteration to reduce CPU usage
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
-        // only proceed when at least one vehicle is waiting in the queue
-        if (_waitingVehicles.getSize() > 0 && !_isBlocked)
+        // admit as many platoons as lanes and conflicts allow
+        TraceScope trace("admitVehicles");
+        while (admitVehicles())
+            ;
+    }
+}
+
+bool Intersection::admitVehicles()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // serve the approaches round robin, so that no approach can starve the others
+    bool hasAdmitted = false;
+    size_t nApproaches = _streets.size();
+    for (size_t i = 0; i < nApproaches; ++i)
+    {
+        size_t approach = (_nextApproach + i) % nApproaches;
+
+        // only proceed when at least one vehicle is waiting and there is room for a platoon while the approach is green
+        int lanes = _streets[approach]->getLanes();
+        int capacity = lanes * _maxPlatoonSize - _occupancy[approach];
+        if (_waitingVehicles[approach]->getSize() == 0 || capacity <= 0 || _trafficLight.getCurrentPhase(approach) == red)
         {
-            // set intersection to "blocked" to prevent other vehicles from entering
-            this->setIsBlocked(true);
+            continue;
+        }
 
-            // permit entry to first vehicle in the queue (FIFO)
-            _waitingVehicles.permitEntryToFirstInQueue();
+        // vehicles of conflicting approaches must have left the intersection
+        bool hasConflict = false;
+        for (size_t other = 0; other < nApproaches && !hasConflict; ++other)
+        {
+            hasConflict = _occupancy[other] > 0 && !(_compatible[approach] & (uint64_t(1) << other));
+        }
+        if (hasConflict)
+        {
+            continue;
         }
+
+        // permit entry to a platoon from the front of the queue of this approach (FIFO)
+        _occupancy[approach] += _waitingVehicles[approach]->permitEntryToPlatoon(capacity, lanes, _headway);
+        hasAdmitted = true;
     }
+    _nextApproach = nApproaches > 0 ? (_nextApproach + 1) % nApproaches : 0;
+
+    return hasAdmitted;
 }
 
 bool Intersection::trafficLightIsGreen()
 {
-   // please include this part once you have solved the final project tasks
-   /*
-   if (_trafficLight.getCurrentPhase() == TrafficLightPhase::green)
-       return true;
-   else
-       return false;
-   */
-
-  return true; // makes traffic light permanently green
+    return _trafficLight.getCurrentPhase() == TrafficLightPhase::green;
 } 
\ No newline at end of file
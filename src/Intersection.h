@@ -4,6 +4,7 @@
 #include <vector>
 #include <future>
 #include <mutex>
+#include <atomic>
 #include <memory>
 #include "TrafficObject.h"
 #include "TrafficLight.h"
@@ -12,20 +13,44 @@
 class Street;
 class Vehicle;
 
+// promise of a platoon vehicle whose entry is due later. It is fulfilled once, either by its timer on the timing
+// wheel or when the intersection is stopped, since a paused wheel does not fire the timer.
+struct ScheduledEntry
+{
+    std::promise<void> promise;
+    std::atomic<bool> isGranted{false};
+
+    void grant()
+    {
+        if (!isGranted.exchange(true))
+        {
+            promise.set_value();
+        }
+    }
+};
+
 // auxiliary class to queue and dequeue waiting vehicles in a thread-safe manner
 class WaitingVehicles
 {
 public:
+    // constructor / desctructor
+    WaitingVehicles();
+
     // getters / setters
     int getSize();
 
     // typical behaviour methods
     void pushBack(std::shared_ptr<Vehicle> vehicle, std::promise<void> &&promise);
     void permitEntryToFirstInQueue();
+    size_t permitEntryToPlatoon(size_t nVehicles, int lanes, long headway); // returns the number of admitted vehicles
+    void releaseAll(); // permits entry to all waiting and scheduled vehicles and to every vehicle queued afterwards
 
 private:
     std::vector<std::shared_ptr<Vehicle>> _vehicles;          // list of all vehicles waiting to enter this intersection
     std::vector<std::promise<void>> _promises; // list of associated promises
+    std::vector<std::shared_ptr<ScheduledEntry>> _scheduledEntries; // admitted vehicles whose entry is still due
+    long _nextRelease;                         // simulation time at which the next vehicle may enter
+    bool _isReleased;                          // set once the intersection has been stopped
     std::mutex _mutex;
 
 };
@@ -33,17 +58,31 @@ private:
 class Intersection : public TrafficObject
 {
 public:
+    static constexpr size_t maxApproaches = 64; // approaches are bits of the signal plan's green masks
+
     // constructor / desctructor
-    Intersection();
+    Intersection(int id = newID);
 
     // getters / setters
-    void setIsBlocked(bool isBlocked);
+    std::vector<std::shared_ptr<Street>> getStreets() { return _streets; }
+    int getApproach(std::shared_ptr<Street> street); // index of the street within all connected streets, -1 if not connected
+    void setSignalPlan(const SignalPlan &plan) { _trafficLight.setSignalPlan(plan); }
+    SignalPlan getSignalPlan() { return _trafficLight.getSignalPlan(); }
+    TrafficLight &getTrafficLight() { return _trafficLight; }
+    void getApproachCounts(std::vector<long> &queueLengths, std::vector<long> &arrivals); // arrivals are reset on every call
+    long getThroughput() { return _vehiclesPassed; }                                     // vehicles which have passed the light
+    void setCompatibleApproaches(uint64_t movementSet); // approaches in the set may cross the intersection at the same time
+    void setMovementSetsFromSignalPlan();               // every phase of the signal plan is a set of non-conflicting movements
+    void setPlatoonParameters(int maxPlatoonSize, long headway); // vehicles per lane admitted at once and their headway in ms
+    void restore(long vehiclesPassed, const std::vector<int> &occupancy); // before the intersection is simulated, see Checkpoint
 
     // typical behaviour methods
     void addVehicleToQueue(std::shared_ptr<Vehicle> vehicle);
     void addStreet(std::shared_ptr<Street> street);
+    void clearStreets(); // disconnects all streets, which hold a reference to the intersection in turn
     std::vector<std::shared_ptr<Street>> queryStreets(std::shared_ptr<Street> incoming); // return pointer to current list of all outgoing streets
     void simulate();
+    void stop();
     void vehicleHasLeft(std::shared_ptr<Vehicle> vehicle);
     bool trafficLightIsGreen();
 
@@ -51,12 +90,21 @@ private:
 
     // typical behaviour methods
     void processVehicleQueue();
+    bool admitVehicles();
 
     // private members
     std::vector<std::shared_ptr<Street>> _streets;   // list of all streets connected to this intersection
-    WaitingVehicles _waitingVehicles; // list of all vehicles and their associated promises waiting to enter the intersection
-    bool _isBlocked;                  // flag indicating wether the intersection is blocked by a vehicle
+    std::vector<std::unique_ptr<WaitingVehicles>> _waitingVehicles; // per approach: vehicles and their associated promises waiting to enter
+    std::vector<int> _occupancy;       // per approach: vehicles which are currently crossing the intersection
+    std::vector<uint64_t> _compatible; // per approach: bit b is set if the approach does not conflict with approach b
+    size_t _nextApproach;              // approach which is served first in the next admission round (round robin)
+    int _maxPlatoonSize;               // vehicles per lane which may be crossing the intersection at the same time
+    long _headway;                     // time gap between consecutive vehicles of a platoon on the same lane in ms
     TrafficLight _trafficLight;
+    std::vector<long> _queueLengths;   // vehicles per approach which are waiting for entry
+    std::vector<long> _arrivals;       // vehicles per approach which arrived since the last measurement
+    std::atomic<long> _vehiclesPassed;
+    std::mutex _mutex;                 // protects the approach counters and the admission state
 };
 
 #endif
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include "TrafficObject.h"
+#include "Logger.h"
+
+// binary log record, the message is only formatted by the writer thread
+struct LogRecord
+{
+    uint64_t clock;      // steady clock in ns, orders the records of different threads
+    long time;           // simulation time in ms
+    const char *format;
+    long args[4];
+    uint32_t thread;     // index of the logging thread in the order of the first record
+    LogLevel level;
+};
+
+// single-producer single-consumer ring buffer of log records owned by one thread
+class LogRing
+{
+public:
+    LogRing(uint32_t thread) : _head(0), _tail(0), _isClosed(false), _thread(thread) {}
+
+    uint32_t getThread() const { return _thread; }
+    bool isClosed() const { return _isClosed.load(std::memory_order_acquire); }
+    bool isEmpty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+    void close() { _isClosed.store(true, std::memory_order_release); }
+
+    // producer side, returns the number of records in the ring after the push or 0 if the ring is full
+    uint64_t push(const LogRecord &record)
+    {
+        uint64_t tail = _tail.load(std::memory_order_relaxed);
+        uint64_t size = tail - _head.load(std::memory_order_acquire);
+        if (size == capacity)
+        {
+            return 0;
+        }
+        _records[tail % capacity] = record;
+        _tail.store(tail + 1, std::memory_order_release);
+        return size + 1;
+    }
+
+    static constexpr uint64_t capacity = 512;
+
+    // consumer side
+    void popAll(std::vector<LogRecord> &records)
+    {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        uint64_t tail = _tail.load(std::memory_order_acquire);
+        for (; head < tail; ++head)
+        {
+            records.push_back(_records[head % capacity]);
+        }
+        _head.store(head, std::memory_order_release);
+    }
+
+private:
+    std::array<LogRecord, capacity> _records;
+    std::atomic<uint64_t> _head, _tail;
+    std::atomic<bool> _isClosed;
+    uint32_t _thread;
+};
+
+// the ring of a thread is closed when the thread exits, the writer releases it once it has been drained
+struct ThreadRing
+{
+    std::shared_ptr<LogRing> ring;
+    ~ThreadRing()
+    {
+        if (ring)
+        {
+            ring->close();
+        }
+    }
+};
+
+static thread_local ThreadRing threadRing;
+
+/* Implementation of class "Logger" */
+
+Logger::Logger()
+{
+    _level = logInfo;
+    _dropped = 0;
+    _nThreads = 0;
+    _isRunning = true;
+    _flushRequests = 0;
+    _flushesDone = 0;
+    _writer = std::thread(&Logger::writeRecords, this);
+}
+
+Logger::~Logger()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isRunning = false;
+    }
+    _wakeWriter.notify_one();
+    _flushed.notify_all();
+    _writer.join();
+}
+
+Logger &Logger::getInstance()
+{
+    static Logger logger;
+    return logger;
+}
+
+void Logger::setOutput(std::string filename)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _file.close();
+    _file.open(filename);
+}
+
+bool Logger::parseLevel(const std::string &name, LogLevel &level)
+{
+    static const char *names[] = {"debug", "info", "warning", "error", "off"};
+    for (int i = logDebug; i <= logOff; ++i)
+    {
+        if (name == names[i])
+        {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<LogRing> Logger::addRing()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _rings.push_back(std::make_shared<LogRing>(_nThreads++));
+    return _rings.back();
+}
+
+void Logger::log(LogLevel level, const char *format, long arg0, long arg1, long arg2, long arg3)
+{
+    if (!isEnabled(level) || level >= logOff) // logOff only switches the output off, it is not a level of its own
+    {
+        return;
+    }
+    if (!threadRing.ring)
+    {
+        threadRing.ring = addRing();
+    }
+
+    LogRecord record;
+    record.clock = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    record.time = TrafficObject::getSimulationTime();
+    record.format = format;
+    record.args[0] = arg0;
+    record.args[1] = arg1;
+    record.args[2] = arg2;
+    record.args[3] = arg3;
+    record.thread = threadRing.ring->getThread();
+    record.level = level;
+    uint64_t size = threadRing.ring->push(record);
+    if (size == 0)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (size == LogRing::capacity / 2)
+    {
+        _wakeWriter.notify_one(); // do not wait for the next regular drain
+    }
+}
+
+void Logger::flush()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    uint64_t request = ++_flushRequests;
+    _wakeWriter.notify_one();
+    _flushed.wait(lock, [this, request] { return _flushesDone >= request || !_isRunning; });
+}
+
+bool Logger::drainRings()
+{
+    thread_local std::vector<LogRecord> records;
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // collect the records of all threads, and release the rings of threads which have exited
+    records.clear();
+    for (auto &ring : _rings)
+    {
+        bool isClosed = ring->isClosed();
+        ring->popAll(records);
+        if (isClosed && ring->isEmpty())
+        {
+            ring.reset();
+        }
+    }
+    _rings.erase(std::remove(_rings.begin(), _rings.end(), nullptr), _rings.end());
+    if (records.empty())
+    {
+        return false;
+    }
+
+    // write the records of all threads in the order in which they have been logged
+    std::sort(records.begin(), records.end(), [](const LogRecord &a, const LogRecord &b) { return a.clock < b.clock; });
+    static const char *levels[] = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+    std::ostream &out = _file.is_open() ? static_cast<std::ostream &>(_file) : std::cout;
+    char message[512];
+    for (auto &record : records)
+    {
+        std::snprintf(message, sizeof(message), record.format, record.args[0], record.args[1], record.args[2], record.args[3]);
+        out << record.time << " " << levels[record.level] << " [" << record.thread << "] " << message << "\n";
+    }
+    out.flush();
+    return true;
+}
+
+void Logger::writeRecords()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_isRunning)
+    {
+        _wakeWriter.wait_for(lock, std::chrono::milliseconds(10));
+        uint64_t flushRequests = _flushRequests;
+
+        lock.unlock();
+        while (drainRings())
+            ;
+        lock.lock();
+
+        _flushesDone = flushRequests;
+        _flushed.notify_all();
+    }
+
+    // write what is left when the logger is destroyed
+    lock.unlock();
+    drainRings();
+}
@@ -0,0 +1,72 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum LogLevel
+{
+    logDebug,
+    logInfo,
+    logWarning,
+    logError,
+    logOff,
+};
+
+// forward declaration, the per-thread record buffers are private to the logger
+class LogRing;
+
+// asynchronous logger. Every thread appends binary records (format string plus integer arguments) to a ring
+// buffer of its own without locking, a background thread formats and writes them in batches. When a ring is
+// full, records are dropped instead of blocking the simulation.
+class Logger
+{
+public:
+    // constructor / desctructor
+    ~Logger();
+
+    // getters / setters
+    static Logger &getInstance();
+    void setLevel(LogLevel level) { _level.store(level, std::memory_order_relaxed); }
+    LogLevel getLevel() const { return _level.load(std::memory_order_relaxed); }
+    bool isEnabled(LogLevel level) const { return level >= getLevel(); }
+    void setOutput(std::string filename); // writes to std::cout unless set
+    uint64_t getDropped() const { return _dropped.load(std::memory_order_relaxed); }
+    static bool parseLevel(const std::string &name, LogLevel &level); // debug, info, warning, error or off
+
+    // typical behaviour methods
+    // the format must be a string literal, all arguments are printed with %ld
+    void log(LogLevel level, const char *format, long arg0 = 0, long arg1 = 0, long arg2 = 0, long arg3 = 0);
+    void flush(); // returns once all records logged before the call have been written
+
+private:
+    // constructor / desctructor
+    Logger();
+
+    // typical behaviour methods
+    std::shared_ptr<LogRing> addRing();
+    void writeRecords(); // executed in the writer thread
+    bool drainRings();   // returns true if records have been written
+
+    // private members
+    std::atomic<LogLevel> _level;
+    std::atomic<uint64_t> _dropped;
+    std::vector<std::shared_ptr<LogRing>> _rings;
+    uint32_t _nThreads;                  // number of threads which have logged so far
+    std::ofstream _file;
+    std::thread _writer;
+    bool _isRunning;
+    uint64_t _flushRequests, _flushesDone;
+    std::mutex _mutex;                   // protects the list of rings and the output
+    std::condition_variable _wakeWriter; // writer drains all rings when woken up or after a timeout
+    std::condition_variable _flushed;    // signals waiting flush() calls
+};
+
+#endif
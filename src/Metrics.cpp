@@ -0,0 +1,328 @@
+#include <algorithm>
+#include "TrafficObject.h"
+#include "Metrics.h"
+
+// every thread is assigned to one shard of each metric, threads are distributed round robin
+static size_t getThreadShard()
+{
+    static std::atomic<size_t> nextShard(0);
+    thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+
+/* Implementation of class "Counter" */
+
+Counter::Counter()
+{
+    for (auto &shard : _shards)
+    {
+        shard.value = 0;
+    }
+}
+
+void Counter::add(uint64_t n)
+{
+    _shards[getThreadShard() % nShards].value.fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t Counter::getValue() const
+{
+    uint64_t value = 0;
+    for (auto &shard : _shards)
+    {
+        value += shard.value.load(std::memory_order_relaxed);
+    }
+    return value;
+}
+
+/* Implementation of class "Histogram" */
+
+Histogram::Histogram()
+{
+    _shards.reset(new Shard[nShards]);
+    for (size_t i = 0; i < nShards; ++i)
+    {
+        for (auto &count : _shards[i].counts)
+        {
+            count = 0;
+        }
+        _shards[i].count = 0;
+        _shards[i].sum = 0;
+        _shards[i].max = 0;
+    }
+}
+
+size_t Histogram::getBucket(uint64_t value)
+{
+    // values below 2^subBucketBits have a bucket of their own, above that every power of two is split
+    // into 2^subBucketBits buckets
+    if (value < (uint64_t(1) << subBucketBits))
+    {
+        return static_cast<size_t>(value);
+    }
+
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent >= maxBits)
+    {
+        return nBuckets - 1;
+    }
+    int shift = exponent - subBucketBits;
+    return static_cast<size_t>(shift) * (1 << subBucketBits) + static_cast<size_t>(value >> shift);
+}
+
+uint64_t Histogram::getUpperBound(size_t bucket)
+{
+    if (bucket < (size_t(1) << subBucketBits))
+    {
+        return bucket;
+    }
+
+    size_t shift = bucket / (1 << subBucketBits) - 1;
+    uint64_t subBucket = bucket - shift * (1 << subBucketBits);
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void Histogram::record(long value)
+{
+    uint64_t v = value > 0 ? static_cast<uint64_t>(value) : 0;
+    Shard &shard = _shards[getThreadShard() % nShards];
+    shard.counts[getBucket(v)].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(v, std::memory_order_relaxed);
+
+    long max = shard.max.load(std::memory_order_relaxed);
+    while (value > max && !shard.max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void Histogram::reset()
+{
+    for (size_t i = 0; i < nShards; ++i)
+    {
+        for (auto &count : _shards[i].counts)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+        _shards[i].count.store(0, std::memory_order_relaxed);
+        _shards[i].sum.store(0, std::memory_order_relaxed);
+        _shards[i].max.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t Histogram::getCount() const
+{
+    uint64_t count = 0;
+    for (size_t i = 0; i < nShards; ++i)
+    {
+        count += _shards[i].count.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+double Histogram::getMean() const
+{
+    uint64_t count = 0, sum = 0;
+    for (size_t i = 0; i < nShards; ++i)
+    {
+        count += _shards[i].count.load(std::memory_order_relaxed);
+        sum += _shards[i].sum.load(std::memory_order_relaxed);
+    }
+    return count > 0 ? static_cast<double>(sum) / count : 0.0;
+}
+
+long Histogram::getMax() const
+{
+    long max = 0;
+    for (size_t i = 0; i < nShards; ++i)
+    {
+        max = std::max(max, _shards[i].max.load(std::memory_order_relaxed));
+    }
+    return max;
+}
+
+long Histogram::getPercentile(double percentile) const
+{
+    // merge the shards and find the bucket in which the requested rank falls
+    std::vector<uint64_t> counts(nBuckets, 0);
+    uint64_t total = 0;
+    for (size_t i = 0; i < nShards; ++i)
+    {
+        for (size_t bucket = 0; bucket < nBuckets; ++bucket)
+        {
+            counts[bucket] += _shards[i].counts[bucket].load(std::memory_order_relaxed);
+        }
+    }
+    for (auto count : counts)
+    {
+        total += count;
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(percentile / 100.0 * total + 0.5));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < nBuckets; ++bucket)
+    {
+        seen += counts[bucket];
+        if (seen >= rank)
+        {
+            return std::min(static_cast<long>(getUpperBound(bucket)), getMax());
+        }
+    }
+    return getMax();
+}
+
+/* Implementation of class "MetricsRegistry" */
+
+MetricsRegistry &MetricsRegistry::getInstance()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+Counter &MetricsRegistry::getCounter(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto &counter = _counters[name];
+    if (!counter)
+    {
+        counter.reset(new Counter());
+    }
+    return *counter;
+}
+
+Gauge &MetricsRegistry::getGauge(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto &gauge = _gauges[name];
+    if (!gauge)
+    {
+        gauge.reset(new Gauge());
+    }
+    return *gauge;
+}
+
+Histogram &MetricsRegistry::getHistogram(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto &histogram = _histograms[name];
+    if (!histogram)
+    {
+        histogram.reset(new Histogram());
+    }
+    return *histogram;
+}
+
+std::vector<std::pair<std::string, const Counter *>> MetricsRegistry::getCounters()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::pair<std::string, const Counter *>> counters;
+    for (auto &counter : _counters)
+    {
+        counters.emplace_back(counter.first, counter.second.get());
+    }
+    return counters;
+}
+
+std::vector<std::pair<std::string, const Gauge *>> MetricsRegistry::getGauges()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::pair<std::string, const Gauge *>> gauges;
+    for (auto &gauge : _gauges)
+    {
+        gauges.emplace_back(gauge.first, gauge.second.get());
+    }
+    return gauges;
+}
+
+std::vector<std::pair<std::string, const Histogram *>> MetricsRegistry::getHistograms()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::vector<std::pair<std::string, const Histogram *>> histograms;
+    for (auto &histogram : _histograms)
+    {
+        histograms.emplace_back(histogram.first, histogram.second.get());
+    }
+    return histograms;
+}
+
+/* Implementation of class "MetricsReporter" */
+
+MetricsReporter::MetricsReporter(std::string filename, long period)
+{
+    _file.open(filename);
+    _previousTime = 0;
+    _period = period;
+    _isRunning = false;
+    _snapshotTimer = TimingWheel::invalidTimer;
+}
+
+MetricsReporter::~MetricsReporter()
+{
+    stop();
+}
+
+void MetricsReporter::writeSnapshot()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    MetricsRegistry &registry = MetricsRegistry::getInstance();
+    long time = TrafficObject::getSimulationTime();
+    double elapsed = (time - _previousTime) / 1000.0;
+
+    _file << "time " << time << "\n";
+    for (auto &counter : registry.getCounters())
+    {
+        uint64_t value = counter.second->getValue();
+        uint64_t &previous = _previousCounts[counter.first];
+        _file << "counter " << counter.first << " " << value << " rate " << (elapsed > 0.0 ? (value - previous) / elapsed : 0.0) << "\n";
+        previous = value;
+    }
+    for (auto &gauge : registry.getGauges())
+    {
+        _file << "gauge " << gauge.first << " " << gauge.second->getValue() << "\n";
+    }
+    for (auto &histogram : registry.getHistograms())
+    {
+        const Histogram &h = *histogram.second;
+        _file << "histogram " << histogram.first << " count " << h.getCount() << " mean " << h.getMean() << " p50 " << h.getPercentile(50)
+              << " p90 " << h.getPercentile(90) << " p99 " << h.getPercentile(99) << " max " << h.getMax() << "\n";
+    }
+    _file << std::endl;
+    _previousTime = time;
+}
+
+void MetricsReporter::simulate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _isRunning = true;
+    _previousTime = TrafficObject::getSimulationTime();
+    scheduleNextSnapshot();
+}
+
+void MetricsReporter::scheduleNextSnapshot()
+{
+    _snapshotTimer = TrafficObject::getTimingWheel().schedule(_period, [this]() {
+        writeSnapshot();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_isRunning)
+        {
+            scheduleNextSnapshot();
+        }
+    });
+}
+
+void MetricsReporter::stop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _isRunning = false;
+    TimingWheel::TimerId timer = _snapshotTimer;
+    _snapshotTimer = TimingWheel::invalidTimer;
+    lock.unlock();
+
+    // a snapshot which is already running does not schedule the next one, but has to return before the object is destroyed
+    TrafficObject::getTimingWheel().cancelAndWait(timer);
+}
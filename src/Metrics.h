@@ -0,0 +1,146 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "TimingWheel.h"
+
+// monotonic counter. Every thread adds to its own cache line, so concurrent updates do not contend,
+// the shards are only summed up when the value is read.
+class Counter
+{
+public:
+    // constructor / desctructor
+    Counter();
+
+    // getters / setters
+    uint64_t getValue() const;
+
+    // typical behaviour methods
+    void add(uint64_t n = 1);
+
+private:
+    static constexpr size_t nShards = 16;
+
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> value;
+    };
+
+    std::array<Shard, nShards> _shards;
+};
+
+// value which can go up and down, e.g. the number of waiting vehicles
+class Gauge
+{
+public:
+    // constructor / desctructor
+    Gauge() : _value(0) {}
+
+    // getters / setters
+    void set(long value) { _value.store(value, std::memory_order_relaxed); }
+    long getValue() const { return _value.load(std::memory_order_relaxed); }
+
+    // typical behaviour methods
+    void add(long n) { _value.fetch_add(n, std::memory_order_relaxed); }
+
+private:
+    std::atomic<long> _value;
+};
+
+// histogram with logarithmic buckets which are linearly subdivided (as in HdrHistogram). Values up to 2^48 are
+// recorded with a relative error of at most 1/16, recording is a single relaxed increment on a sharded bucket.
+class Histogram
+{
+public:
+    // constructor / desctructor
+    Histogram();
+
+    // getters / setters
+    uint64_t getCount() const;
+    double getMean() const;
+    long getMax() const;
+    long getPercentile(double percentile) const; // upper bound of the bucket containing the percentile (0 - 100)
+
+    // typical behaviour methods
+    void record(long value);
+    void reset(); // values recorded concurrently with the reset may be lost
+
+private:
+    static constexpr int subBucketBits = 4;
+    static constexpr int maxBits = 48;
+    static constexpr size_t nBuckets = (maxBits - subBucketBits) * (1 << subBucketBits) + (1 << subBucketBits);
+    static constexpr size_t nShards = 4;
+
+    static size_t getBucket(uint64_t value);
+    static uint64_t getUpperBound(size_t bucket);
+
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<uint64_t>, nBuckets> counts;
+        std::atomic<uint64_t> count, sum;
+        std::atomic<long> max;
+    };
+
+    std::unique_ptr<Shard[]> _shards;
+};
+
+// named metrics of the whole simulation. Metrics are created on first use and never removed, so callers can
+// keep references to them and update them without looking them up again.
+class MetricsRegistry
+{
+public:
+    // getters / setters
+    static MetricsRegistry &getInstance();
+    Counter &getCounter(const std::string &name);
+    Gauge &getGauge(const std::string &name);
+    Histogram &getHistogram(const std::string &name);
+    std::vector<std::pair<std::string, const Counter *>> getCounters();
+    std::vector<std::pair<std::string, const Gauge *>> getGauges();
+    std::vector<std::pair<std::string, const Histogram *>> getHistograms();
+
+private:
+    std::map<std::string, std::unique_ptr<Counter>> _counters;
+    std::map<std::string, std::unique_ptr<Gauge>> _gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> _histograms;
+    std::mutex _mutex;
+};
+
+// writes a snapshot of all metrics to a file at a fixed period of simulation time. Counters are reported
+// together with their rate per second since the previous snapshot.
+class MetricsReporter
+{
+public:
+    // constructor / desctructor
+    MetricsReporter(std::string filename, long period = 1000);
+    ~MetricsReporter();
+
+    // typical behaviour methods
+    void writeSnapshot();
+    void simulate();
+    void stop(); // waits for a running callback, so the object can be destroyed afterwards
+
+private:
+    // typical behaviour methods
+    void scheduleNextSnapshot();
+
+    // private members
+    std::ofstream _file;
+    std::map<std::string, uint64_t> _previousCounts;
+    long _previousTime;
+    long _period;                    // in ms
+    bool _isRunning;
+    TimingWheel::TimerId _snapshotTimer;
+    std::mutex _mutex;
+};
+
+#endif
@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <thread>
+#include "SignalPlan.h"
+#include "NetworkGenerator.h"
+
+/* Implementation of class "NetworkGenerator" */
+
+NetworkGenerator::NetworkGenerator(const NetworkParameters &parameters)
+{
+    _parameters = parameters;
+    _parameters.nColumns = std::max(_parameters.nColumns, 1);
+    _parameters.nRows = std::max(_parameters.nRows, 1);
+    _parameters.nRings = std::max(_parameters.nRings, 1);
+    _parameters.nSpokes = std::min(std::max(_parameters.nSpokes, 3), 64); // approaches of the center are a 64 bit set
+    _parameters.jitter = std::min(std::max(_parameters.jitter, 0.0), 0.24); // cells stay convex, so streets cannot cross
+    _nThreads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+void NetworkGenerator::generate(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles)
+{
+    // the new network is generated on its own and then appended to the existing objects
+    std::vector<std::shared_ptr<Street>> newStreets;
+    std::vector<std::shared_ptr<Intersection>> newIntersections;
+    std::vector<std::shared_ptr<Vehicle>> newVehicles;
+    createIntersections(newIntersections);
+    createStreets(newStreets, newIntersections);
+    setSignalPlans(newIntersections);
+    placeVehicles(newStreets, newVehicles);
+
+    streets.insert(streets.end(), std::make_move_iterator(newStreets.begin()), std::make_move_iterator(newStreets.end()));
+    intersections.insert(intersections.end(), std::make_move_iterator(newIntersections.begin()), std::make_move_iterator(newIntersections.end()));
+    vehicles.insert(vehicles.end(), std::make_move_iterator(newVehicles.begin()), std::make_move_iterator(newVehicles.end()));
+}
+
+void NetworkGenerator::forEachBlock(size_t nItems, const std::function<void(size_t block, size_t begin, size_t end)> &work)
+{
+    // threads take the next block until all are done, small inputs are generated on the calling thread
+    size_t nBlocks = (nItems + blockSize - 1) / blockSize;
+    std::atomic<size_t> nextBlock(0);
+    auto worker = [&]() {
+        for (size_t block = nextBlock++; block < nBlocks; block = nextBlock++)
+        {
+            work(block, block * blockSize, std::min(nItems, (block + 1) * blockSize));
+        }
+    };
+
+    std::vector<std::future<void>> futures;
+    for (size_t i = 1; i < std::min<size_t>(_nThreads, nBlocks); ++i)
+    {
+        futures.emplace_back(std::async(std::launch::async, worker));
+    }
+    worker();
+    for (auto &ftr : futures)
+    {
+        ftr.wait();
+    }
+}
+
+uint32_t NetworkGenerator::getBlockSeed(int stage, size_t block)
+{
+    std::seed_seq sequence{_parameters.seed, static_cast<uint32_t>(stage), static_cast<uint32_t>(block)};
+    uint32_t seed;
+    sequence.generate(&seed, &seed + 1);
+    return seed;
+}
+
+void NetworkGenerator::createIntersections(std::vector<std::shared_ptr<Intersection>> &intersections)
+{
+    const NetworkParameters &p = _parameters;
+    size_t nIntersections = p.layout == layoutRadial ? 1 + static_cast<size_t>(p.nRings) * p.nSpokes : static_cast<size_t>(p.nColumns) * p.nRows;
+    intersections.resize(nIntersections);
+    int firstId = TrafficObject::reserveIDs(static_cast<int>(nIntersections));
+
+    forEachBlock(nIntersections, [&](size_t block, size_t begin, size_t end) {
+        std::mt19937 engine(getBlockSeed(0, block));
+        std::uniform_real_distribution<double> distr(-p.jitter, p.jitter);
+        for (size_t i = begin; i < end; ++i)
+        {
+            // position in pixel coordinates, the radial network is centered on its outermost ring
+            double x, y;
+            if (p.layout == layoutRadial)
+            {
+                double center = (p.nRings + 0.5) * p.spacing;
+                int ring = i == 0 ? 0 : static_cast<int>((i - 1) / p.nSpokes) + 1;
+                double angle = i == 0 ? 0.0 : 2.0 * M_PI * ((i - 1) % p.nSpokes) / p.nSpokes;
+                x = center + ring * p.spacing * std::cos(angle);
+                y = center + ring * p.spacing * std::sin(angle);
+            }
+            else
+            {
+                x = (i % p.nColumns + 0.5) * p.spacing;
+                y = (i / p.nColumns + 0.5) * p.spacing;
+                if (p.layout == layoutRandom)
+                {
+                    x += distr(engine) * p.spacing;
+                    y += distr(engine) * p.spacing;
+                }
+            }
+
+            auto intersection = std::make_shared<Intersection>(firstId + static_cast<int>(i));
+            intersection->setPosition(x, y);
+            intersections[i] = intersection;
+        }
+    });
+}
+
+// appends the streets which start at the given intersection
+void NetworkGenerator::addStreetEnds(size_t intersection, std::mt19937 &engine, std::vector<std::pair<uint32_t, uint32_t>> &ends)
+{
+    const NetworkParameters &p = _parameters;
+    uint32_t i = static_cast<uint32_t>(intersection);
+    if (p.layout == layoutRadial)
+    {
+        // every intersection on a ring connects to its neighbour on the ring and to the next inner ring
+        if (i > 0)
+        {
+            uint32_t ring = (i - 1) / p.nSpokes + 1, spoke = (i - 1) % p.nSpokes;
+            ends.emplace_back(i, 1 + (ring - 1) * p.nSpokes + (spoke + 1) % p.nSpokes);
+            ends.emplace_back(ring == 1 ? 0 : i - p.nSpokes, i);
+        }
+        return;
+    }
+
+    // grid intersections connect to their right and lower neighbour, random ones only with some probability
+    // and to one of the diagonals of the cell to their lower right
+    uint32_t column = i % p.nColumns, row = i / p.nColumns;
+    std::uniform_real_distribution<double> distr(0.0, 1.0);
+    bool isRandom = p.layout == layoutRandom;
+    if (column + 1 < static_cast<uint32_t>(p.nColumns) && (!isRandom || distr(engine) < p.streetProbability))
+    {
+        ends.emplace_back(i, i + 1);
+    }
+    if (row + 1 < static_cast<uint32_t>(p.nRows) && (!isRandom || distr(engine) < p.streetProbability))
+    {
+        ends.emplace_back(i, i + p.nColumns);
+    }
+    if (isRandom && column + 1 < static_cast<uint32_t>(p.nColumns) && row + 1 < static_cast<uint32_t>(p.nRows) && distr(engine) < 0.5 * p.streetProbability)
+    {
+        if (distr(engine) < 0.5)
+        {
+            ends.emplace_back(i, i + p.nColumns + 1);
+        }
+        else
+        {
+            ends.emplace_back(i + 1, i + p.nColumns);
+        }
+    }
+}
+
+void NetworkGenerator::createStreets(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections)
+{
+    // collect the ends of all streets per block of intersections, so that the street order does not depend on the threads
+    size_t nIntersections = intersections.size();
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> ends((nIntersections + blockSize - 1) / blockSize);
+    forEachBlock(nIntersections, [&](size_t block, size_t begin, size_t end) {
+        std::mt19937 engine(getBlockSeed(1, block));
+        for (size_t i = begin; i < end; ++i)
+        {
+            addStreetEnds(i, engine, ends[block]);
+        }
+    });
+
+    std::vector<size_t> offsets(ends.size() + 1, 0);
+    for (size_t block = 0; block < ends.size(); ++block)
+    {
+        offsets[block + 1] = offsets[block] + ends[block].size();
+    }
+    streets.resize(offsets.back());
+
+    // streets are created in parallel, but connected in the order of their index, so that the approaches of
+    // every intersection are numbered the same way in every run
+    int firstId = TrafficObject::reserveIDs(static_cast<int>(streets.size()));
+    forEachBlock(nIntersections, [&](size_t block, size_t begin, size_t end) {
+        for (size_t k = 0; k < ends[block].size(); ++k)
+        {
+            auto street = std::make_shared<Street>(firstId + static_cast<int>(offsets[block] + k));
+            streets[offsets[block] + k] = street;
+        }
+    });
+    for (size_t block = 0; block < ends.size(); ++block)
+    {
+        for (size_t k = 0; k < ends[block].size(); ++k)
+        {
+            streets[offsets[block] + k]->setInIntersection(intersections[ends[block][k].first]);
+            streets[offsets[block] + k]->setOutIntersection(intersections[ends[block][k].second]);
+        }
+    }
+}
+
+void NetworkGenerator::setSignalPlans(std::vector<std::shared_ptr<Intersection>> &intersections)
+{
+    // streets which run closer to the horizontal are served together, then all others. Opposite approaches
+    // of a grid therefore share a phase, which generalizes to the irregular networks.
+    forEachBlock(intersections.size(), [&](size_t block, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            double x, y;
+            intersections[i]->getPosition(x, y);
+            std::vector<std::shared_ptr<Street>> approaches = intersections[i]->getStreets();
+            uint64_t horizontal = 0, vertical = 0;
+            for (size_t approach = 0; approach < approaches.size() && approach < 64; ++approach)
+            {
+                std::shared_ptr<Intersection> other = approaches[approach]->getInIntersection() == intersections[i] ? approaches[approach]->getOutIntersection() : approaches[approach]->getInIntersection();
+                double xOther, yOther;
+                other->getPosition(xOther, yOther);
+                (std::abs(xOther - x) >= std::abs(yOther - y) ? horizontal : vertical) |= uint64_t(1) << approach;
+            }
+            if (horizontal == 0 || vertical == 0)
+            {
+                continue; // all approaches run in the same direction, the light keeps its default cycle
+            }
+
+            SignalPlan plan;
+            plan.addPhase(3000, horizontal);
+            plan.addPhase(3000, vertical);
+            intersections[i]->setSignalPlan(plan);
+            intersections[i]->setMovementSetsFromSignalPlan();
+        }
+    });
+
+    // every row of a grid is an arterial, whose lights are offset by the travel time between them. All
+    // intersections have horizontal and vertical approaches then, so their plans share the cycle length
+    const NetworkParameters &p = _parameters;
+    if (p.layout == layoutGrid && p.greenWaveSpeed > 0.0 && p.nColumns > 1 && p.nRows > 1)
+    {
+        forEachBlock(p.nRows, [&](size_t block, size_t begin, size_t end) {
+            for (size_t row = begin; row < end; ++row)
+            {
+                std::vector<std::shared_ptr<Intersection>> corridor(intersections.begin() + row * p.nColumns, intersections.begin() + (row + 1) * p.nColumns);
+                coordinateGreenWave(corridor, p.greenWaveSpeed);
+            }
+        });
+    }
+}
+
+void NetworkGenerator::placeVehicles(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Vehicle>> &vehicles)
+{
+    size_t nStreets = streets.size();
+    if (nStreets == 0)
+    {
+        return;
+    }
+    uint64_t nVehicles = _parameters.nVehicles >= 0 ? _parameters.nVehicles : static_cast<uint64_t>(std::llround(std::max(0.0, _parameters.vehicleDensity) * nStreets));
+
+    std::vector<std::vector<std::shared_ptr<Vehicle>>> placed((nStreets + blockSize - 1) / blockSize);
+    int firstId = TrafficObject::reserveIDs(static_cast<int>(nVehicles));
+    forEachBlock(nStreets, [&](size_t block, size_t begin, size_t end) {
+        std::mt19937 engine(getBlockSeed(2, block));
+        std::vector<int> slots;
+        for (size_t i = begin; i < end; ++i)
+        {
+            // the vehicles are spread evenly over the streets
+            Street &street = *streets[i];
+            uint64_t first = i * nVehicles / nStreets, count = (i + 1) * nVehicles / nStreets - first;
+
+            // every lane is divided into slots which are one vehicle and the minimum gap apart, the slots
+            // of a direction are numbered across its lanes
+            const CarFollowingParameters &cf = street.getCarFollowingParameters();
+            double pitch = cf.vehicleLength + cf.minimumGap;
+            int slotsPerLane = static_cast<int>((street.getStopLine() - cf.minimumGap) / pitch) + 1;
+            int slotsPerDirection = slotsPerLane * street.getLanes();
+            slots.resize(2 * slotsPerDirection);
+            for (size_t slot = 0; slot < slots.size(); ++slot)
+            {
+                slots[slot] = static_cast<int>(slot);
+            }
+
+            // draw distinct slots and enter them from the front of the street to its start
+            count = std::min<uint64_t>(count, slots.size());
+            for (size_t k = 0; k < count; ++k)
+            {
+                std::swap(slots[k], slots[std::uniform_int_distribution<size_t>(k, slots.size() - 1)(engine)]);
+            }
+            std::sort(slots.begin(), slots.begin() + count, [slotsPerDirection, &street](int a, int b) {
+                return (a % slotsPerDirection) / street.getLanes() > (b % slotsPerDirection) / street.getLanes();
+            });
+            for (size_t k = 0; k < count; ++k)
+            {
+                auto vehicle = std::make_shared<Vehicle>(firstId + static_cast<int>(first + k));
+                auto destination = slots[k] < slotsPerDirection ? street.getOutIntersection() : street.getInIntersection();
+                double position = ((slots[k] % slotsPerDirection) / street.getLanes()) * pitch;
+                LaneHandle handle;
+                if (street.enter(vehicle, destination, 0.0, handle, position))
+                {
+                    vehicle->setCurrentStreet(streets[i]);
+                    vehicle->setCurrentDestination(destination);
+                    vehicle->setLaneHandle(handle);
+                    placed[block].push_back(vehicle);
+                }
+            }
+        }
+    });
+
+    for (auto &blockVehicles : placed)
+    {
+        vehicles.insert(vehicles.end(), std::make_move_iterator(blockVehicles.begin()), std::make_move_iterator(blockVehicles.end()));
+    }
+}
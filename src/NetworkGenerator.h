@@ -0,0 +1,70 @@
+#ifndef NETWORKGENERATOR_H
+#define NETWORKGENERATOR_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+#include "Vehicle.h"
+#include "Street.h"
+#include "Intersection.h"
+
+// shape of a generated road network
+enum NetworkLayout
+{
+    layoutGrid,   // intersections on a regular grid, connected to their horizontal and vertical neighbours
+    layoutRadial, // rings of intersections around a center, connected along the rings and the spokes
+    layoutRandom, // jittered grid with randomly removed streets and diagonals, which is still planar
+};
+
+struct NetworkParameters
+{
+    NetworkLayout layout = layoutGrid;
+    int nColumns = 100, nRows = 100; // grid and random layout: intersections per row and per column
+    int nRings = 10, nSpokes = 16;   // radial layout: rings around the center and intersections per ring (at most 64)
+    double spacing = 200.0;          // distance between neighbouring intersections in pixels
+    double jitter = 0.2;             // random layout: displacement of an intersection relative to the spacing (below 0.25)
+    double streetProbability = 0.8;  // random layout: probability of a street between neighbours, half of it for diagonals
+    double greenWaveSpeed = 0.0;     // grid layout: every row is coordinated as a green wave for this speed in m/s, 0 disables
+    double vehicleDensity = 1.0;     // vehicles per street
+    long nVehicles = -1;             // total number of vehicles, overrides the density if not negative
+    uint32_t seed = 1;               // the network does not depend on the number of threads for a given seed
+};
+
+// generates large road networks directly into the vectors used by the simulation. Intersections, streets and
+// vehicles are created in parallel, in blocks which all have their own random engine. Vehicles are placed at
+// random positions on all streets, each street takes at most as many vehicles as fit in at standstill. Ids
+// follow the order of the objects in their vector and streets are connected to their intersections in the same
+// order, so the ids and approaches are the same in every run.
+class NetworkGenerator
+{
+public:
+    // constructor / desctructor
+    NetworkGenerator(const NetworkParameters &parameters = NetworkParameters());
+
+    // getters / setters
+    void setThreads(int nThreads) { _nThreads = nThreads > 0 ? nThreads : 1; }
+
+    // typical behaviour methods
+    void generate(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles);
+
+private:
+    // typical behaviour methods
+    void createIntersections(std::vector<std::shared_ptr<Intersection>> &intersections);
+    void createStreets(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections);
+    void addStreetEnds(size_t intersection, std::mt19937 &engine, std::vector<std::pair<uint32_t, uint32_t>> &ends);
+    void setSignalPlans(std::vector<std::shared_ptr<Intersection>> &intersections);
+    void placeVehicles(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Vehicle>> &vehicles);
+    void forEachBlock(size_t nItems, const std::function<void(size_t block, size_t begin, size_t end)> &work);
+    uint32_t getBlockSeed(int stage, size_t block);
+
+    // private members
+    static constexpr size_t blockSize = 4096; // items generated at once by one thread
+
+    NetworkParameters _parameters;
+    int _nThreads;
+};
+
+#endif
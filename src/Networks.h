@@ -0,0 +1,27 @@
+#ifndef NETWORKS_H
+#define NETWORKS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Vehicle.h"
+#include "Street.h"
+#include "Intersection.h"
+
+// handwritten networks of real cities, filename is set to the background map of the city
+void createTrafficObjects_Paris(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles, std::string &filename, int nVehicles);
+void createTrafficObjects_NYC(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles, std::string &filename, int nVehicles);
+
+// synthetic city of nColumns x nRows intersections, neighbours are connected by streets. Every intersection
+// serves its horizontal and its vertical streets in alternating phases (see NetworkGenerator for other layouts).
+// With a green wave speed in m/s, the lights of every row are coordinated for traffic along the row.
+void createTrafficObjects_Grid(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles, int nColumns, int nRows, int nVehicles, double spacing = 200.0, double greenWaveSpeed = 0.0);
+
+// lets the threads of all objects finish, intersections are stopped first so that no vehicle is left waiting for entry
+void stopTrafficObjects(std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles);
+
+// drops the references between all objects, so that they are destroyed together with the vectors. The objects
+// must have been stopped before.
+void releaseTrafficObjects(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles);
+
+#endif
@@ -0,0 +1,76 @@
+#include <cmath>
+#include <random>
+#include "RenderAttributes.h"
+
+/* Implementation of class "RenderAttributeTable" */
+
+RenderAttributeTable::RenderAttributeTable()
+{
+    for (auto &chunk : _chunks)
+    {
+        chunk = nullptr;
+    }
+    _default = RenderAttributes{255, 255, 255, 50, 0};
+    _maxRadius = _default.radius;
+}
+
+RenderAttributeTable &RenderAttributeTable::getInstance()
+{
+    static RenderAttributeTable table;
+    return table;
+}
+
+const RenderAttributes &RenderAttributeTable::get(int id) const
+{
+    if (id < 0 || (id >> chunkBits) >= maxChunks)
+    {
+        return _default;
+    }
+
+    RenderAttributes *chunk = _chunks[id >> chunkBits].load(std::memory_order_acquire);
+    return chunk != nullptr ? chunk[id & ((1 << chunkBits) - 1)] : _default;
+}
+
+void RenderAttributeTable::set(int id, const RenderAttributes &attributes)
+{
+    if (id < 0 || (id >> chunkBits) >= maxChunks)
+    {
+        return;
+    }
+
+    // allocate the chunk on first use, filled with the default attributes
+    RenderAttributes *chunk = _chunks[id >> chunkBits].load(std::memory_order_acquire);
+    if (chunk == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        chunk = _chunks[id >> chunkBits].load(std::memory_order_relaxed);
+        if (chunk == nullptr)
+        {
+            _storage[id >> chunkBits].reset(new RenderAttributes[1 << chunkBits]);
+            chunk = _storage[id >> chunkBits].get();
+            for (int i = 0; i < (1 << chunkBits); ++i)
+            {
+                chunk[i] = _default;
+            }
+            _chunks[id >> chunkBits].store(chunk, std::memory_order_release);
+        }
+    }
+    chunk[id & ((1 << chunkBits) - 1)] = attributes;
+
+    int maxRadius = _maxRadius.load(std::memory_order_relaxed);
+    while (attributes.radius > maxRadius && !_maxRadius.compare_exchange_weak(maxRadius, attributes.radius))
+    {
+    }
+}
+
+RenderAttributes RenderAttributeTable::createVehicleAttributes(int id)
+{
+    // random color seeded with the id, scaled so that the length of the color vector is always 255
+    std::mt19937 eng(id);
+    std::uniform_int_distribution<> distr(0, 255);
+    double b = distr(eng), g = distr(eng), r = distr(eng);
+    double length = std::sqrt(b * b + g * g + r * r);
+    double scale = length > 0.0 ? 255.0 / length : 0.0;
+
+    return RenderAttributes{static_cast<uint8_t>(b * scale), static_cast<uint8_t>(g * scale), static_cast<uint8_t>(r * scale), 50, 0};
+}
@@ -0,0 +1,46 @@
+#ifndef RENDERATTRIBUTES_H
+#define RENDERATTRIBUTES_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+// how a traffic object is drawn, computed once when the object is created
+struct RenderAttributes
+{
+    uint8_t blue, green, red;
+    uint8_t radius;  // in map pixels
+    uint16_t sprite; // index of the sprite, 0 draws a filled circle
+};
+
+// table of render attributes indexed by object id. Entries are stored in fixed-size chunks which are never
+// moved, so the renderer can read attributes without locking while new objects are registered.
+class RenderAttributeTable
+{
+public:
+    // constructor / desctructor
+    RenderAttributeTable();
+
+    // getters / setters
+    static RenderAttributeTable &getInstance();
+    const RenderAttributes &get(int id) const; // returns default attributes for unregistered ids
+    int getMaxRadius() const { return _maxRadius; }
+    void set(int id, const RenderAttributes &attributes);
+
+    // typical behaviour methods
+    static RenderAttributes createVehicleAttributes(int id);
+
+private:
+    static constexpr int chunkBits = 12;       // 4096 entries per chunk
+    static constexpr int maxChunks = 1 << 14;  // up to 67M object ids
+
+    std::array<std::atomic<RenderAttributes *>, maxChunks> _chunks;
+    std::unique_ptr<RenderAttributes[]> _storage[maxChunks]; // owns the chunks
+    RenderAttributes _default;
+    std::atomic<int> _maxRadius;               // largest radius of all entries, enlarges culling queries
+    std::mutex _mutex;                         // serializes chunk allocation
+};
+
+#endif
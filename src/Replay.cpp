@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "Metrics.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include "Replay.h"
+
+// positions are stored in tenths of a pixel
+static int32_t toFixed(float value)
+{
+    return static_cast<int32_t>(std::lround(value * 10.0f));
+}
+
+/* Implementation of class "ReplayRecorder" */
+
+ReplayRecorder::ReplayRecorder(std::string filename, std::string backgroundFilename, long period, size_t queueCapacity)
+    : _queue(queueCapacity, MetricsRegistry::getInstance().getCounter("replay.dropped")),
+      _writer(filename, magic, version, backgroundFilename, nColumns, MetricsRegistry::getInstance().getCounter("replay.bytes"))
+{
+    _period = period > 0 ? period : 1;
+    _nextFrameTime = 0;
+    _chunkIntersections = 0;
+    if (!_writer.isOpen())
+    {
+        Logger::getInstance().log(logError, "ReplayRecorder: file could not be opened, frames are dropped");
+    }
+    _thread = std::thread(&ReplayRecorder::write, this);
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+    stop();
+}
+
+void ReplayRecorder::recordFrame(const FrameSnapshot &frame)
+{
+    if (frame.simulationTime < _nextFrameTime)
+    {
+        return;
+    }
+    _nextFrameTime = (frame.simulationTime / _period + 1) * _period;
+
+    // copy into a frame whose arrays have already been allocated, unless the writer thread falls behind
+    if (_queue.reserve(_reserved, 1))
+    {
+        _reserved[0] = frame;
+        _queue.push(std::move(_reserved[0]));
+    }
+}
+
+void ReplayRecorder::stop()
+{
+    // pending frames are still written before the writer thread finishes
+    _queue.close();
+    if (_thread.joinable())
+    {
+        _thread.join();
+        if (_queue.getDropped() > 0)
+        {
+            Logger::getInstance().log(logWarning, "ReplayRecorder: %ld frames dropped because the writer fell behind", static_cast<long>(_queue.getDropped()));
+        }
+    }
+}
+
+void ReplayRecorder::write()
+{
+    Tracer::getInstance().setThreadName("ReplayRecorder");
+    FrameSnapshot frame;
+    while (_queue.pop(frame))
+    {
+        encodeFrame(frame);
+        _queue.recycle(std::move(frame));
+    }
+    _writer.close();
+}
+
+void ReplayRecorder::encodeFrame(const FrameSnapshot &frame)
+{
+    TraceScope trace("encodeFrame");
+
+    // intersections do not move, their positions are stored once per chunk and only the lights with every frame
+    size_t nIntersections = frame.intersectionIds.size();
+    if (_writer.getFrameCount() > 0 && nIntersections != _chunkIntersections)
+    {
+        _writer.writeChunk();
+    }
+    if (_writer.getFrameCount() == 0)
+    {
+        ColumnEncoder &chunkHeader = _writer.getChunkHeader();
+        _chunkIntersections = nIntersections;
+        chunkHeader.putUnsigned(nIntersections);
+        int previousId = 0;
+        for (size_t i = 0; i < nIntersections; ++i)
+        {
+            chunkHeader.putSigned(frame.intersectionIds[i] - previousId);
+            chunkHeader.putSigned(toFixed(frame.intersectionX[i]));
+            chunkHeader.putSigned(toFixed(frame.intersectionY[i]));
+            previousId = frame.intersectionIds[i];
+        }
+    }
+    for (size_t i = 0; i < nIntersections; i += 8)
+    {
+        uint8_t bits = 0;
+        for (size_t k = i; k < std::min(i + 8, nIntersections); ++k)
+        {
+            bits |= (frame.lightIsGreen[k] ? 1 : 0) << (k - i);
+        }
+        _writer.getColumn(3).putByte(bits);
+    }
+
+    // vehicles mostly keep their direction and speed between two frames, so the position predicted from their
+    // previous movement is rarely more than a few pixels off
+    uint32_t chunk = _writer.getChunk();
+    int previousId = 0;
+    for (size_t row = 0; row < frame.vehicleIds.size(); ++row)
+    {
+        int id = frame.vehicleIds[row];
+        ReplayBase &base = getChunkBase(_bases, id, chunk);
+        int32_t x = toFixed(frame.vehicleX[row]), y = toFixed(frame.vehicleY[row]);
+
+        _writer.getColumn(0).putSigned(static_cast<int64_t>(id) - previousId);
+        _writer.getColumn(1).putSigned(static_cast<int64_t>(x) - (base.x + base.dx));
+        _writer.getColumn(2).putSigned(static_cast<int64_t>(y) - (base.y + base.dy));
+
+        previousId = id;
+        base.dx = base.chunk == chunk ? x - base.x : 0;
+        base.dy = base.chunk == chunk ? y - base.y : 0;
+        base.x = x;
+        base.y = y;
+        base.chunk = chunk;
+    }
+
+    _writer.addFrame(frame.simulationTime, frame.vehicleIds.size());
+}
+
+/* Implementation of class "ReplayReader" */
+
+ReplayReader::ReplayReader(std::string filename) : _reader(filename, ReplayRecorder::magic, ReplayRecorder::version)
+{
+    _useCount = 0;
+    _decodeCount = 0;
+    _cache.reserve(cacheSize); // decoded chunks never move, see getFrame
+}
+
+bool ReplayReader::getFrame(long time, FrameSnapshot &frame)
+{
+    const std::vector<ChunkIndex> &index = _reader.getIndex();
+    if (index.empty())
+    {
+        return false;
+    }
+
+    // chunk which contains the time, times before the first and after the last frame show those frames
+    time = std::max(getStartTime(), std::min(getEndTime(), time));
+    auto next = std::upper_bound(index.begin(), index.end(), time, [](long t, const ChunkIndex &entry) { return t < entry.firstTime; });
+    size_t chunk = std::max<size_t>(1, next - index.begin()) - 1;
+    const DecodedChunk *decoded = getChunk(chunk);
+    if (!decoded || decoded->frames.empty())
+    {
+        return false;
+    }
+    const std::vector<FrameSnapshot> &frames = decoded->frames;
+    auto after = std::upper_bound(frames.begin(), frames.end(), time, [](long t, const FrameSnapshot &f) { return t < f.simulationTime; });
+    const FrameSnapshot &previous = *(after == frames.begin() ? after : after - 1);
+
+    // the following frame may be the first one of the next chunk. Decoding it replaces the least recently used
+    // chunk, which cannot be the current one
+    const FrameSnapshot *following = nullptr;
+    if (after != frames.end())
+    {
+        following = &*after;
+    }
+    else if (chunk + 1 < index.size())
+    {
+        const DecodedChunk *nextChunk = getChunk(chunk + 1);
+        following = nextChunk && !nextChunk->frames.empty() ? &nextChunk->frames.front() : nullptr;
+    }
+    frame = previous;
+    frame.simulationTime = time;
+
+    // vehicles are moved linearly between both frames, as long as both contain the same vehicles in the same order
+    if (following && following->simulationTime > previous.simulationTime && following->vehicleIds == previous.vehicleIds)
+    {
+        float weight = static_cast<float>(time - previous.simulationTime) / (following->simulationTime - previous.simulationTime);
+        for (size_t i = 0; i < frame.vehicleIds.size(); ++i)
+        {
+            frame.vehicleX[i] += weight * (following->vehicleX[i] - previous.vehicleX[i]);
+            frame.vehicleY[i] += weight * (following->vehicleY[i] - previous.vehicleY[i]);
+        }
+    }
+
+    return true;
+}
+
+const ReplayReader::DecodedChunk *ReplayReader::getChunk(size_t chunk)
+{
+    for (auto &decoded : _cache)
+    {
+        if (decoded.chunk == chunk)
+        {
+            decoded.lastUse = ++_useCount;
+            return &decoded;
+        }
+    }
+
+    // replace the least recently used chunk
+    if (_cache.size() < cacheSize)
+    {
+        _cache.emplace_back();
+    }
+    DecodedChunk &decoded = *std::min_element(_cache.begin(), _cache.end(), [](const DecodedChunk &a, const DecodedChunk &b) { return a.lastUse < b.lastUse; });
+    if (!decodeChunk(chunk, decoded.frames))
+    {
+        decoded.lastUse = 0;
+        decoded.chunk = _reader.getIndex().size(); // invalid
+        decoded.frames.clear();
+        return nullptr;
+    }
+    decoded.chunk = chunk;
+    decoded.lastUse = ++_useCount;
+    return &decoded;
+}
+
+bool ReplayReader::decodeChunk(size_t chunk, std::vector<FrameSnapshot> &frames)
+{
+    TraceScope trace("decodeChunk");
+    static Histogram &decodeTime = MetricsRegistry::getInstance().getHistogram("replay.decode_us");
+    auto start = std::chrono::steady_clock::now();
+
+    // the intersections are stored once in the chunk header
+    std::vector<int> intersectionIds;
+    std::vector<float> intersectionX, intersectionY;
+    auto readIntersections = [this, &intersectionIds, &intersectionX, &intersectionY](ColumnDecoder &header) {
+        uint64_t nIntersections = header.getUnsigned();
+        if (nIntersections > _raw.size())
+        {
+            return false;
+        }
+        intersectionIds.resize(nIntersections);
+        intersectionX.resize(nIntersections);
+        intersectionY.resize(nIntersections);
+        int id = 0;
+        for (uint64_t i = 0; i < nIntersections; ++i)
+        {
+            id += static_cast<int>(header.getSigned());
+            intersectionIds[i] = id;
+            intersectionX[i] = header.getSigned() / 10.0f;
+            intersectionY[i] = header.getSigned() / 10.0f;
+        }
+        return true;
+    };
+    ChunkLayout layout;
+    if (!_reader.readChunk(chunk, _raw) || !layout.parse(_raw, ReplayRecorder::nColumns, readIntersections))
+    {
+        return false;
+    }
+    std::vector<ColumnDecoder> &columns = layout.columns;
+    size_t nFrames = layout.times.size(), nIntersections = intersectionIds.size();
+    frames.resize(nFrames);
+
+    uint32_t marker = ++_decodeCount;
+    for (size_t f = 0; f < nFrames; ++f)
+    {
+        FrameSnapshot &frame = frames[f];
+        frame.frameNumber = f;
+        frame.simulationTime = layout.times[f];
+        frame.intersectionIds = intersectionIds;
+        frame.intersectionX = intersectionX;
+        frame.intersectionY = intersectionY;
+        frame.lightIsGreen.resize(nIntersections);
+        for (uint64_t i = 0; i < nIntersections; i += 8)
+        {
+            uint8_t bits = columns[3].getByte();
+            for (uint64_t k = i; k < std::min<uint64_t>(i + 8, nIntersections); ++k)
+            {
+                frame.lightIsGreen[k] = (bits >> (k - i)) & 1;
+            }
+        }
+
+        frame.vehicleIds.resize(layout.nRows[f]);
+        frame.vehicleX.resize(layout.nRows[f]);
+        frame.vehicleY.resize(layout.nRows[f]);
+        int id = 0;
+        for (uint64_t row = 0; row < layout.nRows[f]; ++row)
+        {
+            id += static_cast<int>(columns[0].getSigned());
+            if (id < 0 || id > maxLogVehicleId)
+            {
+                return false;
+            }
+            ReplayBase &base = getChunkBase(_bases, id, marker);
+            int32_t x = base.x + base.dx + static_cast<int32_t>(columns[1].getSigned());
+            int32_t y = base.y + base.dy + static_cast<int32_t>(columns[2].getSigned());
+            base.dx = base.chunk == marker ? x - base.x : 0;
+            base.dy = base.chunk == marker ? y - base.y : 0;
+            base.x = x;
+            base.y = y;
+            base.chunk = marker;
+
+            frame.vehicleIds[row] = id;
+            frame.vehicleX[row] = x / 10.0f;
+            frame.vehicleY[row] = y / 10.0f;
+        }
+    }
+    for (auto &column : columns)
+    {
+        if (!column.isValid())
+        {
+            return false;
+        }
+    }
+
+    decodeTime.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+    return true;
+}
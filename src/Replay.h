@@ -0,0 +1,108 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ChunkLog.h"
+#include "FrameSnapshot.h"
+
+// values of the previous row of a vehicle in the current chunk, positions are predicted from its last movement
+struct ReplayBase
+{
+    uint32_t chunk = 0; // values are zero in a chunk which does not contain a row of the vehicle yet
+    int32_t x = 0, y = 0, dx = 0, dy = 0;
+};
+
+// records the frames drawn by Graphics into a replay log, which can be played back without simulating again.
+// The snapshot publisher hands over every frame, a frame is copied whenever one is due and encoded by a writer
+// thread, to which it is passed through a FrameQueue. Frames which are due while the queue is full are dropped
+// and counted, so the timing wheel thread of the publisher never waits for the disk.
+//
+// File layout: a chunked log (see ChunkWriter) with magic "TSRP", whose header data is the name of the background
+// file. The chunk header holds the intersections (number, then id, x and y of each), the columns are: vehicle id
+// (delta to the previous row), x and y (difference to the position predicted from the previous two rows of the
+// same vehicle, see ReplayBase) and the traffic lights as one bit per intersection. Positions are stored in
+// tenths of a pixel, all integers within a chunk are (zigzag) varints.
+class ReplayRecorder
+{
+public:
+    // file format
+    static constexpr uint32_t magic = 0x50525354; // "TSRP"
+    static constexpr uint32_t version = 1;
+    static constexpr int nColumns = 4;
+
+    // constructor / desctructor
+    ReplayRecorder(std::string filename, std::string backgroundFilename, long period = 100, size_t queueCapacity = 4);
+    ~ReplayRecorder();
+
+    // getters / setters
+    void setFramesPerChunk(int nFrames) { _writer.setFramesPerChunk(nFrames); } // before the first frame
+    uint64_t getBytesWritten() { return _writer.getBytesWritten(); }
+    uint64_t getDroppedFrames() { return _queue.getDropped(); }
+
+    // typical behaviour methods
+    void recordFrame(const FrameSnapshot &frame); // copies the frame if one is due at its time, drops it while the queue is full
+    void stop();                                  // writes all pending frames and the index and closes the file
+
+private:
+    // typical behaviour methods
+    void write(); // executed in the writer thread
+    void encodeFrame(const FrameSnapshot &frame);
+
+    // private members
+    long _period;                                 // in ms
+    long _nextFrameTime;                          // only used by the thread of the publisher
+    std::vector<FrameSnapshot> _reserved;         // only used by the thread of the publisher
+    FrameQueue<FrameSnapshot> _queue;
+    std::thread _thread;
+
+    // only used by the writer thread
+    ChunkWriter _writer;
+    std::vector<ReplayBase> _bases;               // indexed by vehicle id
+    size_t _chunkIntersections;                   // a new chunk is started if the number of intersections changes
+};
+
+// plays back a replay log. The file is mapped into memory and only the chunks around the requested time are
+// decoded, the most recently used of them are kept, so playing in either direction decodes every chunk once.
+class ReplayReader
+{
+public:
+    // constructor / desctructor
+    ReplayReader(std::string filename);
+
+    // getters / setters
+    bool isOpen() { return _reader.isOpen(); }
+    std::string getBackgroundFilename() { return _reader.getHeader(); }
+    long getStartTime() { return _reader.getIndex().empty() ? 0 : static_cast<long>(_reader.getIndex().front().firstTime); }
+    long getEndTime() { return _reader.getIndex().empty() ? 0 : static_cast<long>(_reader.getIndex().back().lastTime); }
+    size_t getChunkCount() { return _reader.getIndex().size(); }
+
+    // typical behaviour methods
+    bool getFrame(long time, FrameSnapshot &frame); // interpolates between the recorded frames around the time, returns false if the chunk is corrupt
+
+private:
+    struct DecodedChunk
+    {
+        size_t chunk;
+        uint64_t lastUse;
+        std::vector<FrameSnapshot> frames;
+    };
+
+    // typical behaviour methods
+    const DecodedChunk *getChunk(size_t chunk); // decodes the chunk unless it is cached, nullptr if it is corrupt
+    bool decodeChunk(size_t chunk, std::vector<FrameSnapshot> &frames);
+
+    // private members
+    static constexpr size_t cacheSize = 3;
+
+    ChunkReader _reader;
+    std::vector<DecodedChunk> _cache;
+    uint64_t _useCount;
+    uint32_t _decodeCount;                        // marks the bases of the chunk being decoded
+    std::vector<ReplayBase> _bases;               // indexed by vehicle id
+    std::string _raw;
+};
+
+#endif
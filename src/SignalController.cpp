@@ -0,0 +1,148 @@
+#include "Intersection.h"
+#include "SignalController.h"
+
+/* Implementation of class "FixedTimePolicy" */
+
+void FixedTimePolicy::evaluate(const std::vector<SignalState> &states, std::vector<SignalDecision> &decisions)
+{
+    for (size_t i = 0; i < states.size(); ++i)
+    {
+        decisions[i] = states[i].timeInPhase >= states[i].plannedDuration ? advancePhase : holdPhase;
+    }
+}
+
+/* Implementation of class "ActuatedPolicy" */
+
+ActuatedPolicy::ActuatedPolicy(long minGreen, long maxGreen, long gap)
+{
+    _minGreen = minGreen;
+    _maxGreen = maxGreen;
+    _gap = gap;
+}
+
+void ActuatedPolicy::evaluate(const std::vector<SignalState> &states, std::vector<SignalDecision> &decisions)
+{
+    for (size_t i = 0; i < states.size(); ++i)
+    {
+        const SignalState &state = states[i];
+        if (state.timeInPhase < _minGreen)
+        {
+            decisions[i] = holdPhase;
+        }
+        else if (state.timeInPhase >= _maxGreen)
+        {
+            decisions[i] = advancePhase;
+        }
+        else if (state.queueOnRed == 0)
+        {
+            decisions[i] = holdPhase; // nobody is waiting for the other phases
+        }
+        else if (state.queueOnGreen > 0 || state.arrivalRate * _gap / 1000.0 >= 1.0)
+        {
+            decisions[i] = holdPhase; // green is still being used
+        }
+        else
+        {
+            decisions[i] = advancePhase; // green approaches are empty, serve the waiting vehicles
+        }
+    }
+}
+
+/* Implementation of class "SignalController" */
+
+SignalController::SignalController(std::shared_ptr<SignalControlPolicy> policy, long controlStep)
+{
+    _policy = policy;
+    _controlStep = controlStep;
+    _stepTimer = TimingWheel::invalidTimer;
+}
+
+SignalController::~SignalController()
+{
+    stop();
+}
+
+void SignalController::setPolicy(std::shared_ptr<SignalControlPolicy> policy)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _policy = policy;
+}
+
+void SignalController::addIntersection(std::shared_ptr<Intersection> intersection)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    intersection->getTrafficLight().setActuated(true);
+    _intersections.push_back(intersection);
+}
+
+void SignalController::simulate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stepTimer = TrafficObject::getTimingWheel().schedule(_controlStep, [this]() { controlStep(); });
+}
+
+void SignalController::stop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    TimingWheel::TimerId timer = _stepTimer;
+    _stepTimer = TimingWheel::invalidTimer;
+    lock.unlock();
+
+    // a step which cannot be cancelled anymore waits for the lock, it returns once it sees the invalid timer
+    TrafficObject::getTimingWheel().cancelAndWait(timer);
+}
+
+/* timer callback which is executed on the timing wheel thread */
+void SignalController::controlStep()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stepTimer == TimingWheel::invalidTimer)
+    {
+        return; // controller has been stopped while this step was pending
+    }
+
+    // measure all intersections
+    _states.resize(_intersections.size());
+    _decisions.assign(_intersections.size(), holdPhase);
+    std::vector<long> queueLengths, arrivals;
+    for (size_t i = 0; i < _intersections.size(); ++i)
+    {
+        TrafficLight &trafficLight = _intersections[i]->getTrafficLight();
+        SignalPlan plan = trafficLight.getSignalPlan();
+        SignalState &state = _states[i];
+        state.phase = trafficLight.getPhaseIndex();
+        state.timeInPhase = trafficLight.getTimeInPhase();
+        state.plannedDuration = plan.isEmpty() ? 0 : plan.getPhase(state.phase).duration;
+        state.queueOnGreen = 0;
+        state.queueOnRed = 0;
+
+        long arrivalsOnGreen = 0;
+        uint64_t greenMask = plan.isEmpty() ? ~uint64_t(0) : plan.getPhase(state.phase).greenMask;
+        _intersections[i]->getApproachCounts(queueLengths, arrivals);
+        for (size_t approach = 0; approach < queueLengths.size(); ++approach)
+        {
+            if (greenMask & (uint64_t(1) << approach))
+            {
+                state.queueOnGreen += queueLengths[approach];
+                arrivalsOnGreen += arrivals[approach];
+            }
+            else
+            {
+                state.queueOnRed += queueLengths[approach];
+            }
+        }
+        state.arrivalRate = arrivalsOnGreen * 1000.0 / _controlStep;
+    }
+
+    // let the policy decide for all intersections at once and apply the decisions
+    _policy->evaluate(_states, _decisions);
+    for (size_t i = 0; i < _intersections.size(); ++i)
+    {
+        if (_decisions[i] == advancePhase)
+        {
+            _intersections[i]->getTrafficLight().advancePhase();
+        }
+    }
+
+    _stepTimer = TrafficObject::getTimingWheel().schedule(_controlStep, [this]() { controlStep(); });
+}
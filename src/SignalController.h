@@ -0,0 +1,96 @@
+#ifndef SIGNALCONTROLLER_H
+#define SIGNALCONTROLLER_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "TimingWheel.h"
+
+// forward declarations to avoid include cycle
+class Intersection;
+
+// measurements of a single intersection taken at every control step
+struct SignalState
+{
+    size_t phase;          // currently active phase of the signal plan
+    long timeInPhase;      // in ms
+    long plannedDuration;  // duration of the active phase according to the signal plan, in ms
+    long queueOnGreen;     // vehicles waiting on approaches which are green in the active phase
+    long queueOnRed;       // vehicles waiting on all other approaches
+    double arrivalRate;    // vehicles per second arriving on the green approaches during the last control step
+};
+
+enum SignalDecision
+{
+    holdPhase,    // extend the active phase
+    advancePhase, // truncate the active phase and switch to the next one
+};
+
+// interface of a signal control policy, which decides for all intersections at once
+class SignalControlPolicy
+{
+public:
+    virtual ~SignalControlPolicy() {}
+
+    // typical behaviour methods
+    virtual void evaluate(const std::vector<SignalState> &states, std::vector<SignalDecision> &decisions) = 0;
+};
+
+// reproduces fixed-time control, every phase ends after its planned duration
+class FixedTimePolicy : public SignalControlPolicy
+{
+public:
+    // typical behaviour methods
+    void evaluate(const std::vector<SignalState> &states, std::vector<SignalDecision> &decisions) override;
+};
+
+// actuated control, green is extended while vehicles are queued or keep arriving on the green approaches
+// and truncated once the green approaches are empty, bounded by a minimum and a maximum green time
+class ActuatedPolicy : public SignalControlPolicy
+{
+public:
+    // constructor / desctructor
+    ActuatedPolicy(long minGreen = 2000, long maxGreen = 10000, long gap = 1500);
+
+    // typical behaviour methods
+    void evaluate(const std::vector<SignalState> &states, std::vector<SignalDecision> &decisions) override;
+
+private:
+    long _minGreen; // in ms
+    long _maxGreen; // in ms
+    long _gap;      // green is extended as long as at least one vehicle is expected to arrive within this time, in ms
+};
+
+// measures the queues of all registered intersections at a fixed control step, evaluates the policy
+// in one batch and switches the traffic lights (which are put into actuated mode) accordingly
+class SignalController
+{
+public:
+    // constructor / desctructor
+    SignalController(std::shared_ptr<SignalControlPolicy> policy, long controlStep = 100);
+    ~SignalController();
+
+    // getters / setters
+    void setPolicy(std::shared_ptr<SignalControlPolicy> policy);
+
+    // typical behaviour methods
+    void addIntersection(std::shared_ptr<Intersection> intersection);
+    void simulate();
+    void stop(); // waits for a pending control step, so the controller can be destroyed afterwards
+
+private:
+    // typical behaviour methods
+    void controlStep();
+
+    // private members
+    std::vector<std::shared_ptr<Intersection>> _intersections;
+    std::shared_ptr<SignalControlPolicy> _policy;
+    std::vector<SignalState> _states;
+    std::vector<SignalDecision> _decisions;
+    long _controlStep;                // in ms
+    TimingWheel::TimerId _stepTimer;
+    std::mutex _mutex;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <stdexcept>
+#include "Street.h"
+#include "Intersection.h"
+#include "SignalPlan.h"
+
+/* Implementation of class "SignalPlan" */
+
+SignalPlan::SignalPlan()
+{
+    _bucketSize = 1;
+    _cycleLength = 0;
+    _offset = 0;
+}
+
+void SignalPlan::setOffset(long offset)
+{
+    _offset = offset;
+}
+
+void SignalPlan::addPhase(long duration, uint64_t greenMask)
+{
+    if (duration <= 0)
+    {
+        throw std::invalid_argument("SignalPlan::addPhase: phase duration must be positive");
+    }
+
+    _phases.push_back(SignalPhase{duration, greenMask});
+    compile();
+}
+
+void SignalPlan::compile()
+{
+    // accumulate phase starts and find the shortest phase
+    _phaseStarts.clear();
+    _cycleLength = 0;
+    _bucketSize = _phases.front().duration;
+    for (auto &phase : _phases)
+    {
+        _phaseStarts.push_back(_cycleLength);
+        _cycleLength += phase.duration;
+        _bucketSize = std::min(_bucketSize, phase.duration);
+    }
+    _phaseStarts.push_back(_cycleLength);
+
+    // as no bucket is wider than the shortest phase, every bucket contains at most one phase change
+    size_t nBuckets = (_cycleLength + _bucketSize - 1) / _bucketSize;
+    _lookup.resize(nBuckets);
+    size_t phase = 0;
+    for (size_t b = 0; b < nBuckets; ++b)
+    {
+        while (static_cast<long>(b) * _bucketSize >= _phaseStarts[phase + 1])
+        {
+            ++phase;
+        }
+        _lookup[b] = static_cast<uint16_t>(phase);
+    }
+}
+
+long SignalPlan::cycleTime(long time) const
+{
+    long t = (time - _offset) % _cycleLength;
+    return t < 0 ? t + _cycleLength : t;
+}
+
+size_t SignalPlan::phaseAt(long time) const
+{
+    if (_phases.empty())
+    {
+        return 0;
+    }
+
+    long t = cycleTime(time);
+    size_t phase = _lookup[t / _bucketSize];
+    return t >= _phaseStarts[phase + 1] ? phase + 1 : phase;
+}
+
+uint64_t SignalPlan::greenMaskAt(long time) const
+{
+    // without a plan all approaches are permanently green
+    return _phases.empty() ? ~uint64_t(0) : _phases[phaseAt(time)].greenMask;
+}
+
+long SignalPlan::nextChangeAt(long time) const
+{
+    if (_phases.empty())
+    {
+        return -1;
+    }
+
+    return time + _phaseStarts[phaseAt(time) + 1] - cycleTime(time);
+}
+
+int SignalPlan::firstGreenPhase(int approach) const
+{
+    for (size_t phase = 0; phase < _phases.size(); ++phase)
+    {
+        if (_phases[phase].greenMask & (uint64_t(1) << approach))
+        {
+            return static_cast<int>(phase);
+        }
+    }
+
+    return -1;
+}
+
+/* Implementation of green wave coordination */
+
+void coordinateGreenWave(const std::vector<std::shared_ptr<Intersection>> &corridor, double speed)
+{
+    if (corridor.size() < 2 || speed <= 0.0)
+    {
+        return;
+    }
+
+    // the first intersection is the reference, its cycle starts when the platoon departs
+    long cycleLength = corridor.front()->getSignalPlan().getCycleLength();
+    long departure = corridor.front()->getSignalPlan().getOffset();
+    double travelTime = 0.0; // in ms
+
+    for (size_t i = 1; i < corridor.size(); ++i)
+    {
+        // find the street connecting this intersection with its predecessor on the corridor
+        std::vector<std::shared_ptr<Street>> streets = corridor[i]->getStreets();
+        auto it = std::find_if(streets.begin(), streets.end(), [&](std::shared_ptr<Street> &street) {
+            return street->getInIntersection() == corridor[i - 1] || street->getOutIntersection() == corridor[i - 1];
+        });
+        if (it == streets.end())
+        {
+            throw std::invalid_argument("coordinateGreenWave: corridor intersections are not connected");
+        }
+        travelTime += (*it)->getLength() / speed * 1000.0;
+
+        SignalPlan plan = corridor[i]->getSignalPlan();
+        if (plan.getCycleLength() != cycleLength)
+        {
+            throw std::invalid_argument("coordinateGreenWave: all signal plans must have the same cycle length");
+        }
+
+        // shift the plan so that the green phase of the approach starts when the platoon arrives
+        int phase = plan.firstGreenPhase(static_cast<int>(it - streets.begin()));
+        if (phase < 0)
+        {
+            continue; // approach is never green, nothing to coordinate
+        }
+        long offset = (departure + static_cast<long>(travelTime) - plan.getPhaseStart(phase)) % cycleLength;
+        plan.setOffset(offset < 0 ? offset + cycleLength : offset);
+        corridor[i]->setSignalPlan(plan);
+    }
+}
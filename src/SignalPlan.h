@@ -0,0 +1,62 @@
+#ifndef SIGNALPLAN_H
+#define SIGNALPLAN_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// forward declarations to avoid include cycle
+class Intersection;
+
+// a single phase of a signal plan, bit i of greenMask is set if approach i (the i-th street
+// connected to the intersection) has right of way during this phase
+struct SignalPhase
+{
+    long duration;     // in ms
+    uint64_t greenMask;
+};
+
+// fixed-time signal plan which is compiled into a lookup table so that the active phase can be
+// determined in O(1) for any point in simulation time
+class SignalPlan
+{
+public:
+    // constructor / desctructor
+    SignalPlan();
+
+    // getters / setters
+    void setOffset(long offset);
+    long getOffset() const { return _offset; }
+    long getCycleLength() const { return _cycleLength; }
+    size_t getPhaseCount() const { return _phases.size(); }
+    const SignalPhase &getPhase(size_t phase) const { return _phases.at(phase); }
+    long getPhaseStart(size_t phase) const { return _phaseStarts.at(phase); }
+    bool isEmpty() const { return _phases.empty(); }
+
+    // typical behaviour methods
+    void addPhase(long duration, uint64_t greenMask);
+    size_t phaseAt(long time) const;           // index of the phase active at the given simulation time
+    uint64_t greenMaskAt(long time) const;     // approaches with right of way at the given simulation time
+    long nextChangeAt(long time) const;        // simulation time of the next phase change after the given time
+    int firstGreenPhase(int approach) const;   // first phase in which the approach is green, -1 if there is none
+
+private:
+    // typical behaviour methods
+    void compile();
+    long cycleTime(long time) const;
+
+    // private members
+    std::vector<SignalPhase> _phases;
+    std::vector<long> _phaseStarts; // start of every phase within the cycle (plus the cycle length as sentinel)
+    std::vector<uint16_t> _lookup;  // phase active at the beginning of every bucket of the cycle
+    long _bucketSize;               // bucket width in ms, never larger than the shortest phase
+    long _cycleLength;              // in ms
+    long _offset;                   // in ms, shifts the start of the cycle relative to simulation time 0
+};
+
+// coordinate the signal plans along a corridor of consecutive intersections so that a platoon leaving
+// the first intersection at the start of its cycle arrives at every following intersection at the beginning
+// of the green phase for its approach (green wave). All plans must have the same cycle length.
+void coordinateGreenWave(const std::vector<std::shared_ptr<Intersection>> &corridor, double speed);
+
+#endif
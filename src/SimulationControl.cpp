@@ -0,0 +1,69 @@
+#include <algorithm>
+#include "TrafficObject.h"
+#include "Logger.h"
+#include "SimulationControl.h"
+
+/* Implementation of class "SimulationControl" */
+
+SimulationControl::SimulationControl()
+{
+    _isStopRequested = false;
+    _stopTimer = TimingWheel::invalidTimer;
+}
+
+SimulationControl &SimulationControl::getInstance()
+{
+    static SimulationControl control;
+    return control;
+}
+
+bool SimulationControl::isPaused()
+{
+    return TrafficObject::getTimingWheel().isPaused();
+}
+
+void SimulationControl::pause()
+{
+    TrafficObject::getTimingWheel().pause();
+    Logger::getInstance().log(logInfo, "Simulation paused at %ld ms", TrafficObject::getSimulationTime());
+}
+
+void SimulationControl::resume()
+{
+    TrafficObject::getTimingWheel().resume();
+    Logger::getInstance().log(logInfo, "Simulation resumed at %ld ms", TrafficObject::getSimulationTime());
+}
+
+void SimulationControl::step(long duration)
+{
+    TimingWheel &timingWheel = TrafficObject::getTimingWheel();
+    timingWheel.step(std::max(1L, duration / static_cast<long>(timingWheel.getTickDuration().count())));
+}
+
+void SimulationControl::requestStop()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_isStopRequested.exchange(true))
+    {
+        TrafficObject::getTimingWheel().cancel(_stopTimer);
+        _stopCondition.notify_all();
+    }
+}
+
+void SimulationControl::stopAt(long simulationTime)
+{
+    TimingWheel &timingWheel = TrafficObject::getTimingWheel();
+    long tickDuration = static_cast<long>(timingWheel.getTickDuration().count());
+    std::lock_guard<std::mutex> lock(_mutex);
+    timingWheel.cancel(_stopTimer);
+
+    // the delay is taken from the clock now, moving the clock later does not move the stop
+    long delay = std::max(1L, (simulationTime - TrafficObject::getSimulationTime()) / tickDuration);
+    _stopTimer = timingWheel.schedule(delay, [this]() { requestStop(); });
+}
+
+void SimulationControl::waitForStop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _stopCondition.wait(lock, [this] { return _isStopRequested.load(); });
+}
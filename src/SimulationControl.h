@@ -0,0 +1,44 @@
+#ifndef SIMULATIONCONTROL_H
+#define SIMULATIONCONTROL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include "TimingWheel.h"
+
+// pauses, steps and stops the whole simulation. Simulation time is the tick count of the shared timing wheel,
+// so pausing the wheel holds all timers (streets, signals, snapshots, metrics) while vehicle and intersection
+// threads keep waiting for their events. A stop request ends the loops of the main program and of Graphics,
+// the traffic objects are then stopped and joined by their owner (see stopTrafficObjects).
+class SimulationControl
+{
+public:
+    // getters / setters
+    static SimulationControl &getInstance();
+    bool isPaused();
+    bool isStopRequested() const { return _isStopRequested.load(std::memory_order_relaxed); }
+    // held shared while state moves between objects (a vehicle changing streets), held exclusively to take a checkpoint
+    std::shared_mutex &getStateMutex() { return _stateMutex; }
+
+    // typical behaviour methods
+    void pause();
+    void resume();
+    void step(long duration);         // advances a paused simulation by the given simulation time in ms
+    void requestStop();
+    void stopAt(long simulationTime); // requests a stop once the absolute simulation time (in ms) has been reached, after the clock has been set by a restore
+    void waitForStop();
+
+private:
+    // constructor / desctructor
+    SimulationControl();
+
+    // private members
+    std::atomic<bool> _isStopRequested;
+    TimingWheel::TimerId _stopTimer;
+    std::mutex _mutex;
+    std::condition_variable _stopCondition;
+    std::shared_mutex _stateMutex;
+};
+
+#endif
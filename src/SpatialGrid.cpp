@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <future>
+#include "SpatialGrid.h"
+
+/* Implementation of class "SpatialGrid" */
+
+SpatialGrid::SpatialGrid(float cellSize)
+{
+    _cellSize = cellSize > 0.0f ? cellSize : 1.0f;
+    _cols = 1;
+    _rows = 1;
+    _cellStart.assign(2, 0);
+}
+
+void SpatialGrid::setBounds(float width, float height)
+{
+    _cols = std::max(1, static_cast<int>(std::ceil(width / _cellSize)));
+    _rows = std::max(1, static_cast<int>(std::ceil(height / _cellSize)));
+    _cellStart.assign(static_cast<size_t>(_cols) * _rows + 1, 0);
+    _items.clear();
+}
+
+int SpatialGrid::getColumn(float x) const
+{
+    return std::min(std::max(static_cast<int>(x / _cellSize), 0), _cols - 1);
+}
+
+int SpatialGrid::getRow(float y) const
+{
+    return std::min(std::max(static_cast<int>(y / _cellSize), 0), _rows - 1);
+}
+
+int SpatialGrid::getCellCount(int col, int row) const
+{
+    size_t cell = static_cast<size_t>(row) * _cols + col;
+    return static_cast<int>(_cellStart[cell + 1] - _cellStart[cell]);
+}
+
+void SpatialGrid::build(const std::vector<float> &xs, const std::vector<float> &ys, int nThreads)
+{
+    // every thread sorts a contiguous chunk of the items, small inputs are sorted on the calling thread
+    size_t nItems = xs.size();
+    size_t nCells = _cellStart.size() - 1;
+    size_t nChunks = std::max<size_t>(1, std::min<size_t>(nThreads, nItems / minItemsPerThread));
+    size_t chunkSize = (nItems + nChunks - 1) / nChunks;
+    auto forEachChunk = [nChunks](const std::function<void(size_t)> &work) {
+        std::vector<std::future<void>> futures;
+        for (size_t chunk = 1; chunk < nChunks; ++chunk)
+        {
+            futures.emplace_back(std::async(std::launch::async, work, chunk));
+        }
+        work(0);
+        for (auto &ftr : futures)
+        {
+            ftr.wait();
+        }
+    };
+
+    // count the items per cell and chunk
+    _itemCells.resize(nItems);
+    _counts.assign(nChunks * nCells, 0);
+    forEachChunk([&](size_t chunk) {
+        uint32_t *counts = &_counts[chunk * nCells];
+        for (size_t i = chunk * chunkSize, end = std::min(nItems, i + chunkSize); i < end; ++i)
+        {
+            _itemCells[i] = static_cast<uint32_t>(getRow(ys[i]) * _cols + getColumn(xs[i]));
+            ++counts[_itemCells[i]];
+        }
+    });
+
+    // prefix sum gives the first slot of every cell, and within a cell the first slot of every chunk
+    uint32_t total = 0;
+    for (size_t cell = 0; cell < nCells; ++cell)
+    {
+        _cellStart[cell] = total;
+        for (size_t chunk = 0; chunk < nChunks; ++chunk)
+        {
+            uint32_t count = _counts[chunk * nCells + cell];
+            _counts[chunk * nCells + cell] = total;
+            total += count;
+        }
+    }
+    _cellStart[nCells] = total;
+
+    // scatter the items into their cells, keeping their original order within a cell
+    _items.resize(nItems);
+    forEachChunk([&](size_t chunk) {
+        uint32_t *next = &_counts[chunk * nCells];
+        for (size_t i = chunk * chunkSize, end = std::min(nItems, i + chunkSize); i < end; ++i)
+        {
+            uint32_t slot = next[_itemCells[i]]++;
+            _items[slot] = static_cast<uint32_t>(i);
+        }
+    });
+}
+
+void SpatialGrid::queryRect(float x0, float y0, float x1, float y1, std::vector<uint32_t> &result) const
+{
+    result.clear();
+    if (_items.empty())
+    {
+        return;
+    }
+
+    // the cells of a row are contiguous, so a whole row span can be copied at once
+    int col0 = getColumn(x0), col1 = getColumn(x1);
+    for (int row = getRow(y0), row1 = getRow(y1); row <= row1; ++row)
+    {
+        size_t first = static_cast<size_t>(row) * _cols;
+        result.insert(result.end(), _items.begin() + _cellStart[first + col0], _items.begin() + _cellStart[first + col1 + 1]);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// uniform grid over a rectangular area of the map (in pixels). Items are sorted by cell with a counting sort,
+// so the grid is rebuilt in linear time and all items of a cell are stored contiguously. Items outside of the
+// bounds are assigned to the nearest border cell.
+class SpatialGrid
+{
+public:
+    // constructor / desctructor
+    SpatialGrid(float cellSize = 100.0f);
+
+    // getters / setters
+    void setBounds(float width, float height);
+    float getCellSize() const { return _cellSize; }
+    int getColumns() const { return _cols; }
+    int getRows() const { return _rows; }
+    int getCellCount(int col, int row) const; // number of items in a cell
+    size_t getSize() const { return _items.size(); }
+
+    // typical behaviour methods
+    void build(const std::vector<float> &xs, const std::vector<float> &ys, int nThreads = 1);
+    void queryRect(float x0, float y0, float x1, float y1, std::vector<uint32_t> &result) const; // items of all cells overlapping the rectangle
+
+private:
+    // typical behaviour methods
+    int getColumn(float x) const;
+    int getRow(float y) const;
+
+    // private members
+    static constexpr size_t minItemsPerThread = 4096; // smaller builds are not worth starting a thread for
+
+    float _cellSize;
+    int _cols, _rows;
+    std::vector<uint32_t> _cellStart;  // index of the first item of every cell in _items (plus the total as sentinel)
+    std::vector<uint32_t> _items;      // item indices sorted by cell
+    std::vector<uint32_t> _itemCells;  // cell of every item, reused between builds
+    std::vector<uint32_t> _counts;     // per-thread cell histograms, reused between builds
+};
+
+#endif
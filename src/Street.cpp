@@ -1,13 +1,19 @@
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 #include "Vehicle.h"
 #include "Intersection.h"
 #include "Street.h"
 
 
-Street::Street()
+Street::Street(int id) : TrafficObject(id)
 {
     _type = ObjectType::objectStreet;
     _length = 1000.0; // in m
+    _lanes = 1;
+    _stopLine = 0.9 * _length;
+    _model = modelMicroscopic;
+    resizeLanes();
 }
 
 void Street::setInIntersection(std::shared_ptr<Intersection> in)
@@ -21,3 +27,529 @@ void Street::setOutIntersection(std::shared_ptr<Intersection> out)
     _interOut = out;
     out->addStreet(get_shared_this()); // add this street to list of streets connected to the intersection
 }
+
+void Street::setLanes(int lanes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _lanes = lanes > 0 ? lanes : 1;
+    resizeLanes();
+}
+
+void Street::setModel(StreetModel model)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (model == _model)
+    {
+        return;
+    }
+
+    // convert the vehicles which are already on the street, keeping their order and remaining travel times
+    long time = getSimulationTime();
+    for (auto &lane : _laneVehicles)
+    {
+        if (model == modelMesoscopic)
+        {
+            toQueue(lane, time);
+        }
+        else
+        {
+            fromQueue(lane, time);
+        }
+    }
+    _model = model;
+}
+
+void Street::toQueue(Lane &lane, long time)
+{
+    const CarFollowingParameters &p = _parameters;
+    double crossingSpeed = p.desiredSpeed * p.intersectionSpeedFactor;
+    long previous = time;
+    for (size_t k = lane.begin; k < lane.end; ++k)
+    {
+        // a vehicle needs the free-flow time to the stop line, or the crossing time to the end of the street,
+        // and cannot get there before the vehicle in front of it
+        long remaining;
+        if (lane.state[k] & entryGranted)
+        {
+            remaining = static_cast<long>(std::max(0.0, _length - lane.position[k]) / crossingSpeed * 1000.0);
+            lane.speed[k] = crossingSpeed;
+        }
+        else
+        {
+            remaining = static_cast<long>(std::max(0.0, _stopLine - lane.position[k]) / p.desiredSpeed * 1000.0);
+            lane.speed[k] = p.desiredSpeed;
+        }
+        lane.exitTime[k] = std::max(time + remaining, previous);
+        previous = lane.exitTime[k];
+    }
+    lane.lastExitTime = previous;
+}
+
+void Street::fromQueue(Lane &lane, long time)
+{
+    const CarFollowingParameters &p = _parameters;
+    double crossingSpeed = p.desiredSpeed * p.intersectionSpeedFactor;
+    for (size_t k = lane.begin; k < lane.end; ++k)
+    {
+        // place the vehicle where it would be when driving at the speed the queue model has assumed
+        double remaining = std::max(0L, lane.exitTime[k] - time) / 1000.0;
+        if (lane.state[k] & entryGranted)
+        {
+            lane.position[k] = std::max(_stopLine, _length - remaining * crossingSpeed);
+            lane.speed[k] = crossingSpeed;
+        }
+        else if (lane.state[k] & entryRequested)
+        {
+            lane.position[k] = _stopLine - p.minimumGap; // waiting at the stop line
+            lane.speed[k] = 0.0;
+        }
+        else
+        {
+            lane.position[k] = std::max(0.0, _stopLine - remaining * p.desiredSpeed);
+            lane.speed[k] = p.desiredSpeed;
+        }
+
+        // queues can be denser than the car-following model allows, vehicles are then moved back as far as possible
+        if (k > lane.begin && lane.position[k] > lane.position[k - 1] - p.vehicleLength - p.minimumGap)
+        {
+            lane.position[k] = std::max(0.0, lane.position[k - 1] - p.vehicleLength - p.minimumGap);
+            lane.speed[k] = std::min(lane.speed[k], lane.speed[k - 1]);
+        }
+    }
+}
+
+void Street::setCarFollowingParameters(const CarFollowingParameters &parameters)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _parameters = parameters;
+    resizeLanes();
+}
+
+// lanes can only be resized before the first vehicle has entered the street
+void Street::resizeLanes()
+{
+    // a lane holds at most as many vehicles as fit in at standstill, its arrays grow when vehicles enter (see enter)
+    _laneCapacity = static_cast<size_t>(_length / (_parameters.vehicleLength + _parameters.minimumGap)) + 1;
+    _laneVehicles.assign(2 * _lanes, Lane());
+}
+
+int Street::getVehicleCount()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t count = 0;
+    for (auto &lane : _laneVehicles)
+    {
+        count += lane.end - lane.begin;
+    }
+    return static_cast<int>(count);
+}
+
+size_t Street::getIndex(const LaneHandle &handle)
+{
+    Lane &lane = _laneVehicles[handle.lane];
+    return lane.begin + static_cast<size_t>(handle.sequence - lane.frontSequence);
+}
+
+double Street::getSpeed(const LaneHandle &handle)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _laneVehicles[handle.lane].speed[getIndex(handle)];
+}
+
+void Street::getLaneVehicles(std::vector<LaneVehicleState> &vehicles, std::vector<uint32_t> &laneSizes, std::vector<long> &lastExitTimes, std::vector<std::pair<int, int>> &roomRequests)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (Lane &l : _laneVehicles)
+    {
+        for (size_t k = l.begin; k < l.end; ++k)
+        {
+            vehicles.push_back(LaneVehicleState{l.vehicleIds[k], l.position[k], l.speed[k], l.exitTime[k], (l.state[k] & entryGranted) != 0});
+        }
+        laneSizes.push_back(static_cast<uint32_t>(l.end - l.begin));
+        lastExitTimes.push_back(l.lastExitTime);
+    }
+    for (auto &request : _roomRequests)
+    {
+        roomRequests.emplace_back(request.vehicle->getID(), request.firstLane);
+    }
+}
+
+void Street::setLaneVehicles(int lane, const std::vector<LaneVehicle> &vehicles, long lastExitTime)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Lane &l = _laneVehicles.at(lane);
+    size_t size = std::max<size_t>(4, vehicles.size());
+    l = Lane();
+    l.position.resize(size);
+    l.speed.resize(size);
+    l.acceleration.resize(size);
+    l.exitTime.resize(size);
+    l.state.resize(size);
+    l.vehicleIds.resize(size);
+    l.vehicles.resize(size);
+    l.lastExitTime = lastExitTime;
+
+    // requests for entry and for the next street are raised again by the next update, the vehicle threads
+    // which had been waiting for them do not exist anymore
+    double xIn, yIn, xOut, yOut;
+    _interIn->getPosition(xIn, yIn);
+    _interOut->getPosition(xOut, yOut);
+    for (const LaneVehicle &vehicle : vehicles)
+    {
+        l.position[l.end] = vehicle.position;
+        l.speed[l.end] = vehicle.speed;
+        l.acceleration[l.end] = 0.0;
+        l.exitTime[l.end] = vehicle.exitTime;
+        l.state[l.end] = vehicle.isEntryGranted ? entryRequested | entryGranted : 0;
+        l.vehicleIds[l.end] = vehicle.vehicle->getID();
+        l.vehicles[l.end] = vehicle.vehicle;
+        ++l.end;
+
+        double completion = vehicle.position / _length;
+        if (lane < _lanes)
+        {
+            vehicle.vehicle->setPosition(xIn + completion * (xOut - xIn), yIn + completion * (yOut - yIn));
+        }
+        else
+        {
+            vehicle.vehicle->setPosition(xOut + completion * (xIn - xOut), yOut + completion * (yIn - yOut));
+        }
+    }
+}
+
+size_t Street::appendVehicleStates(std::vector<int> &vehicleIds, std::vector<float> &positions, std::vector<float> &speeds, std::vector<uint8_t> &states)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t count = 0;
+    for (size_t i = 0; i < _laneVehicles.size(); ++i)
+    {
+        // whole ranges of the lane arrays are copied, only the lane has to be added to the states
+        const Lane &lane = _laneVehicles[i];
+        vehicleIds.insert(vehicleIds.end(), lane.vehicleIds.begin() + lane.begin, lane.vehicleIds.begin() + lane.end);
+        positions.insert(positions.end(), lane.position.begin() + lane.begin, lane.position.begin() + lane.end);
+        speeds.insert(speeds.end(), lane.speed.begin() + lane.begin, lane.speed.begin() + lane.end);
+        size_t first = states.size();
+        states.insert(states.end(), lane.state.begin() + lane.begin, lane.state.begin() + lane.end);
+        uint8_t laneBits = static_cast<uint8_t>(std::min<size_t>(i, maxRecordedLane) << laneShift);
+        for (size_t k = first; k < states.size(); ++k)
+        {
+            states[k] |= laneBits;
+        }
+        count += lane.end - lane.begin;
+    }
+    return count;
+}
+
+bool Street::enter(std::shared_ptr<Vehicle> vehicle, std::shared_ptr<Intersection> destination, double speed, LaneHandle &handle, double position)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    position = std::max(0.0, std::min(position, _stopLine - _parameters.minimumGap));
+    int best = findLane(destination->getID() == _interOut->getID() ? 0 : _lanes, position);
+    if (best < 0)
+    {
+        return false; // all lanes are backed up to the start of the street
+    }
+
+    // the arrays grow with the number of vehicles up to twice the capacity of the lane, so that large networks
+    // with mostly empty streets stay small. Once the end has been reached with room at the front, the vehicles
+    // are moved to the start of the arrays instead.
+    Lane &lane = _laneVehicles[best];
+    if (lane.end == lane.position.size())
+    {
+        size_t count = lane.end - lane.begin;
+        if (lane.position.size() < 2 * _laneCapacity && 2 * count >= lane.position.size())
+        {
+            size_t size = std::min(2 * _laneCapacity, std::max<size_t>(4, 2 * lane.position.size()));
+            lane.position.resize(size);
+            lane.speed.resize(size);
+            lane.acceleration.resize(size);
+            lane.exitTime.resize(size);
+            lane.state.resize(size);
+            lane.vehicleIds.resize(size);
+            lane.vehicles.resize(size);
+        }
+        else
+        {
+            std::copy(lane.position.begin() + lane.begin, lane.position.begin() + lane.end, lane.position.begin());
+            std::copy(lane.speed.begin() + lane.begin, lane.speed.begin() + lane.end, lane.speed.begin());
+            std::copy(lane.exitTime.begin() + lane.begin, lane.exitTime.begin() + lane.end, lane.exitTime.begin());
+            std::copy(lane.state.begin() + lane.begin, lane.state.begin() + lane.end, lane.state.begin());
+            std::copy(lane.vehicleIds.begin() + lane.begin, lane.vehicleIds.begin() + lane.end, lane.vehicleIds.begin());
+            std::move(lane.vehicles.begin() + lane.begin, lane.vehicles.begin() + lane.end, lane.vehicles.begin());
+            lane.begin = 0;
+            lane.end = count;
+        }
+    }
+
+    // append the vehicle at the back of the lane
+    lane.position[lane.end] = position;
+    lane.speed[lane.end] = std::min(speed, _parameters.desiredSpeed);
+    lane.acceleration[lane.end] = 0.0;
+    lane.state[lane.end] = 0;
+    if (_model == modelMesoscopic)
+    {
+        // the vehicle reaches the stop line after the free-flow travel time, but not earlier than the saturation
+        // headway after its predecessor, which limits the flow of the lane
+        const CarFollowingParameters &p = _parameters;
+        long freeFlowTime = static_cast<long>((_stopLine - position) / p.desiredSpeed * 1000.0);
+        long headway = static_cast<long>(((p.vehicleLength + p.minimumGap) / p.desiredSpeed + p.timeHeadway) * 1000.0);
+        long time = getSimulationTime();
+        lane.exitTime[lane.end] = lane.begin == lane.end ? time + freeFlowTime : std::max(time + freeFlowTime, lane.lastExitTime + headway);
+        lane.lastExitTime = lane.exitTime[lane.end];
+        lane.speed[lane.end] = p.desiredSpeed;
+    }
+    lane.vehicleIds[lane.end] = vehicle->getID();
+    lane.vehicles[lane.end] = vehicle;
+    handle.lane = best;
+    handle.sequence = lane.frontSequence + (lane.end - lane.begin);
+    ++lane.end;
+
+    return true;
+}
+
+void Street::requestRoom(std::shared_ptr<Vehicle> vehicle, std::shared_ptr<Intersection> destination)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // room may have become free since the vehicle has tried to enter
+    int first = destination->getID() == _interOut->getID() ? 0 : _lanes;
+    if (findLane(first, 0.0) >= 0)
+    {
+        vehicle->notifyStreetEvent(Vehicle::eventRoomAvailable);
+        return;
+    }
+    _roomRequests.push_back(RoomRequest{vehicle, first});
+}
+
+int Street::findLane(int first, double position)
+{
+    // pick the lane of the driving direction with the most room behind the last vehicle
+    int best = -1;
+    double bestRoom = 0.0;
+    for (int i = first; i < first + _lanes; ++i)
+    {
+        Lane &lane = _laneVehicles[i];
+        if (lane.end - lane.begin >= _laneCapacity)
+        {
+            continue;
+        }
+
+        // mesoscopic lanes only limit the number of vehicles, the one with the fewest vehicles has the most room
+        double room = (lane.end == lane.begin ? _length : lane.position[lane.end - 1] - _parameters.vehicleLength) - position;
+        if (_model == modelMesoscopic)
+        {
+            room = static_cast<double>(_laneCapacity - (lane.end - lane.begin)) * _length;
+        }
+        if (room >= _parameters.minimumGap && room > bestRoom)
+        {
+            best = i;
+            bestRoom = room;
+        }
+    }
+    return best;
+}
+
+void Street::notifyRoomRequests()
+{
+    // all vehicles waiting for a direction with room try to enter, those which do not fit request room again
+    for (size_t k = 0; k < _roomRequests.size();)
+    {
+        if (findLane(_roomRequests[k].firstLane, 0.0) >= 0)
+        {
+            _roomRequests[k].vehicle->notifyStreetEvent(Vehicle::eventRoomAvailable);
+            _roomRequests[k] = std::move(_roomRequests.back());
+            _roomRequests.pop_back();
+        }
+        else
+        {
+            ++k;
+        }
+    }
+}
+
+void Street::grantEntry(const LaneHandle &handle)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Lane &lane = _laneVehicles[handle.lane];
+    size_t k = getIndex(handle);
+    lane.state[k] |= entryGranted;
+    if (_model == modelMesoscopic)
+    {
+        // crossing the intersection takes as long as driving behind the stop line at the reduced speed
+        double crossingSpeed = _parameters.desiredSpeed * _parameters.intersectionSpeedFactor;
+        lane.exitTime[k] = getSimulationTime() + static_cast<long>((_length - _stopLine) / crossingSpeed * 1000.0);
+        lane.speed[k] = crossingSpeed;
+    }
+}
+
+void Street::leave(const LaneHandle &handle)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    Lane &lane = _laneVehicles[handle.lane];
+    if (lane.begin == lane.end || getIndex(handle) != lane.begin)
+    {
+        return; // vehicles cannot overtake, so only the first vehicle of a lane reaches the end of the street
+    }
+
+    lane.vehicles[lane.begin].reset();
+    ++lane.begin;
+    ++lane.frontSequence;
+    if (lane.begin == lane.end)
+    {
+        lane.begin = 0;
+        lane.end = 0;
+    }
+    notifyRoomRequests();
+}
+
+size_t Street::update(double timeStep)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t nVehicles = 0;
+    for (auto &lane : _laneVehicles)
+    {
+        nVehicles += lane.end - lane.begin;
+    }
+
+    // pixel coordinates of both ends of the street
+    double xIn, yIn, xOut, yOut;
+    _interIn->getPosition(xIn, yIn);
+    _interOut->getPosition(xOut, yOut);
+
+    if (_model == modelMesoscopic)
+    {
+        long time = getSimulationTime();
+        for (int i = 0; i < _lanes; ++i)
+        {
+            updateQueue(_laneVehicles[i], time, xIn, yIn, xOut - xIn, yOut - yIn);
+            updateQueue(_laneVehicles[_lanes + i], time, xOut, yOut, xIn - xOut, yIn - yOut);
+        }
+        return nVehicles;
+    }
+
+    for (int i = 0; i < _lanes; ++i)
+    {
+        updateLane(_laneVehicles[i], timeStep, xIn, yIn, xOut - xIn, yOut - yIn);
+        updateLane(_laneVehicles[_lanes + i], timeStep, xOut, yOut, xIn - xOut, yIn - yOut);
+    }
+
+    // the last vehicles have moved away from the start of the street
+    if (!_roomRequests.empty())
+    {
+        notifyRoomRequests();
+    }
+    return nVehicles;
+}
+
+void Street::updateQueue(Lane &lane, long time, double x1, double y1, double dx, double dy)
+{
+    // vehicles only have to be looked at when they jump, so the cost does not depend on the number of vehicles
+    for (size_t k = lane.begin; k < lane.end; ++k)
+    {
+        uint8_t &state = lane.state[k];
+        if (!(state & entryGranted))
+        {
+            // the first vehicle without entry jumps to the stop line once its travel time has passed
+            if (!(state & entryRequested) && time >= lane.exitTime[k])
+            {
+                state |= entryRequested;
+                lane.position[k] = _stopLine;
+                lane.vehicles[k]->setPosition(x1 + _stopLine / _length * dx, y1 + _stopLine / _length * dy);
+                lane.vehicles[k]->notifyStreetEvent(Vehicle::eventApproaching);
+            }
+            return;
+        }
+
+        // vehicles leave in the order in which they have entered, so only the first one can reach the end
+        if (k == lane.begin && !(state & exitReached) && time >= lane.exitTime[k])
+        {
+            state |= exitReached;
+            lane.position[k] = _length;
+            lane.vehicles[k]->setPosition(x1 + dx, y1 + dy);
+            lane.vehicles[k]->notifyStreetEvent(Vehicle::eventExitReached);
+        }
+    }
+}
+
+void Street::updateLane(Lane &lane, double timeStep, double x1, double y1, double dx, double dy)
+{
+    const CarFollowingParameters &p = _parameters;
+    double brakingTerm = 2.0 * std::sqrt(p.maxAcceleration * p.comfortableDeceleration);
+
+    // accelerations from the state at the beginning of the step, the leader of a vehicle is the previous element
+    for (size_t k = lane.begin; k < lane.end; ++k)
+    {
+        double v = lane.speed[k], x = lane.position[k];
+        double desiredSpeed = x >= _stopLine ? p.desiredSpeed * p.intersectionSpeedFactor : p.desiredSpeed;
+        double ratio = v / desiredSpeed;
+        double interaction = 0.0; // (desired gap / actual gap)^2 of the most restrictive obstacle
+
+        if (k > lane.begin)
+        {
+            double gap = std::max(lane.position[k - 1] - p.vehicleLength - x, 0.01);
+            double desiredGap = p.minimumGap + std::max(0.0, v * p.timeHeadway + v * (v - lane.speed[k - 1]) / brakingTerm);
+            interaction = (desiredGap / gap) * (desiredGap / gap);
+        }
+        if (!(lane.state[k] & entryGranted) && x <= _stopLine)
+        {
+            // the stop line acts like a vehicle at standstill until entry has been granted
+            double gap = std::max(_stopLine - x, 0.01);
+            double desiredGap = p.minimumGap + v * p.timeHeadway + v * v / brakingTerm;
+            interaction = std::max(interaction, (desiredGap / gap) * (desiredGap / gap));
+        }
+
+        double acceleration = p.maxAcceleration * (1.0 - ratio * ratio * ratio * ratio - interaction);
+        lane.acceleration[k] = std::max(acceleration, -p.maxDeceleration);
+    }
+
+    // integrate front to back, so that every vehicle can be kept behind the new position of its leader
+    bool isFirstWaiting = true;
+    for (size_t k = lane.begin; k < lane.end; ++k)
+    {
+        double x = lane.position[k], v = lane.speed[k];
+        double vNew = std::max(0.0, v + lane.acceleration[k] * timeStep);
+        double xNew = x + 0.5 * (v + vNew) * timeStep;
+        uint8_t &state = lane.state[k];
+
+        if (k > lane.begin && xNew > lane.position[k - 1] - p.vehicleLength)
+        {
+            xNew = std::max(x, lane.position[k - 1] - p.vehicleLength);
+            vNew = std::min(vNew, lane.speed[k - 1]);
+        }
+        if (!(state & entryGranted) && x <= _stopLine && xNew >= _stopLine)
+        {
+            xNew = _stopLine;
+            vNew = 0.0;
+        }
+        if (xNew >= _length)
+        {
+            // hold at the end of the street until the vehicle has found room on its next street
+            xNew = _length;
+            if (state & exitReached)
+            {
+                vNew = 0.0;
+            }
+            else
+            {
+                state |= exitReached;
+                lane.vehicles[k]->notifyStreetEvent(Vehicle::eventExitReached);
+            }
+        }
+        lane.position[k] = xNew;
+        lane.speed[k] = vNew;
+
+        // the first vehicle without entry requests it once it has to start braking for the stop line
+        if (!(state & entryGranted))
+        {
+            if (isFirstWaiting && !(state & entryRequested) && _stopLine - xNew <= vNew * vNew / (2.0 * p.comfortableDeceleration) + 2.0 * p.minimumGap)
+            {
+                state |= entryRequested;
+                lane.vehicles[k]->notifyStreetEvent(Vehicle::eventApproaching);
+            }
+            isFirstWaiting = false;
+        }
+
+        double completion = xNew / _length;
+        lane.vehicles[k]->setPosition(x1 + completion * dx, y1 + completion * dy);
+    }
+}
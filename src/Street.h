@@ -1,32 +1,152 @@
 #ifndef STREET_H
 #define STREET_H
 
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include "TrafficObject.h"
 
 // forward declaration to avoid include cycle
 class Intersection;
+class Vehicle;
+
+// parameters of the intelligent driver model (IDM) used for all vehicles on a street
+struct CarFollowingParameters
+{
+    double desiredSpeed = 400.0;            // in m/s
+    double maxAcceleration = 400.0;         // in m/s^2
+    double comfortableDeceleration = 600.0; // in m/s^2
+    double maxDeceleration = 2400.0;        // physical limit, also caps the response to sudden obstacles
+    double minimumGap = 20.0;               // bumper-to-bumper distance at standstill in m
+    double timeHeadway = 0.1;               // in s
+    double vehicleLength = 30.0;            // in m
+    double intersectionSpeedFactor = 0.1;   // desired speed behind the stop line relative to the desired speed
+};
+
+// how vehicles are simulated on a street
+enum StreetModel
+{
+    modelMicroscopic, // continuous positions from the car-following model
+    modelMesoscopic,  // every lane is a queue, vehicles jump to the stop line after the free-flow travel time
+};
+
+// lane position of a vehicle on a street
+struct LaneHandle
+{
+    int lane = -1;         // index into the lanes of the street, -1 if the vehicle is not on a street
+    uint64_t sequence = 0; // number of vehicles which have entered the lane before this one
+};
+
+// state of a vehicle on a lane, used to checkpoint and restore a street
+struct LaneVehicle
+{
+    std::shared_ptr<Vehicle> vehicle;
+    double position, speed;
+    long exitTime;       // mesoscopic model only
+    bool isEntryGranted; // vehicle may cross the intersection at the end of the street
+};
+
+// the same state copied while a checkpoint holds the simulation. The vehicle is referred to by its id, which is
+// kept with the lane, so that the vehicle objects are not touched
+struct LaneVehicleState
+{
+    int vehicleId;
+    double position, speed;
+    long exitTime;
+    bool isEntryGranted;
+};
 
 class Street : public TrafficObject, public std::enable_shared_from_this<Street>
 {
 public:
+    // state flags of a vehicle on a lane, recorded in trajectories together with the lane in the upper bits
+    enum LaneState : uint8_t
+    {
+        entryRequested = 1,
+        entryGranted = 2,
+        exitReached = 4,
+    };
+    static constexpr int laneShift = 4;
+    static constexpr int maxRecordedLane = 0xff >> laneShift; // higher lanes are recorded as this one
+
     // constructor / desctructor
-    Street();
+    Street(int id = newID);
 
     // getters / setters
     double getLength() { return _length; }
+    void setLanes(int lanes);
+    int getLanes() { return _lanes; } // lanes per driving direction
+    int getLaneCapacity() { return static_cast<int>(_laneCapacity); } // maximum number of vehicles per lane
     void setInIntersection(std::shared_ptr<Intersection> in);
     void setOutIntersection(std::shared_ptr<Intersection> out);
     std::shared_ptr<Intersection> getOutIntersection() { return _interOut; }
     std::shared_ptr<Intersection> getInIntersection() { return _interIn; }
+    void setModel(StreetModel model); // vehicles on the street are converted to the new model
+    StreetModel getModel() { return _model; }
+    void setCarFollowingParameters(const CarFollowingParameters &parameters);
+    const CarFollowingParameters &getCarFollowingParameters() { return _parameters; }
+    double getStopLine() { return _stopLine; } // distance from the start of the street at which vehicles wait for entry
+    int getVehicleCount();
+    double getSpeed(const LaneHandle &handle);
+    // appends all lanes as in enter, each from the front to the back, and the id of every vehicle waiting for room
+    // together with the first lane of its direction. One lock for the whole street keeps a checkpoint short
+    void getLaneVehicles(std::vector<LaneVehicleState> &vehicles, std::vector<uint32_t> &laneSizes, std::vector<long> &lastExitTimes, std::vector<std::pair<int, int>> &roomRequests);
+    void setLaneVehicles(int lane, const std::vector<LaneVehicle> &vehicles, long lastExitTime); // before the street is simulated, see Checkpoint
+    size_t appendVehicleStates(std::vector<int> &vehicleIds, std::vector<float> &positions, std::vector<float> &speeds, std::vector<uint8_t> &states); // returns the number of vehicles
 
     // typical behaviour methods
+    bool enter(std::shared_ptr<Vehicle> vehicle, std::shared_ptr<Intersection> destination, double speed, LaneHandle &handle, double position = 0.0); // returns false if there is no room behind the last vehicle
+    void requestRoom(std::shared_ptr<Vehicle> vehicle, std::shared_ptr<Intersection> destination);                         // signals eventRoomAvailable once the vehicle could enter at the start
+    void grantEntry(const LaneHandle &handle);                                                                             // vehicle may pass the stop line
+    void leave(const LaneHandle &handle);                                                                                  // only the first vehicle of a lane can leave
+    size_t update(double timeStep);                                                                                        // advances all vehicles by one time step in s, returns their number
 
     // miscellaneous
     std::shared_ptr<Street> get_shared_this() { return shared_from_this(); }
 
 private:
+    // vehicles on one lane ordered from the front to the back. The arrays are only appended to at the back
+    // and consumed at the front, so the leader of a vehicle is always the previous element.
+    struct Lane
+    {
+        std::vector<double> position, speed, acceleration;
+        std::vector<long> exitTime; // mesoscopic model: time at which the vehicle reaches the stop line or leaves the street
+        std::vector<uint8_t> state;
+        std::vector<int> vehicleIds;  // copies of the vehicle ids, so that trajectories are recorded without touching the vehicles
+        std::vector<std::shared_ptr<Vehicle>> vehicles;
+        size_t begin = 0, end = 0;  // vehicles on the lane are stored in [begin, end)
+        uint64_t frontSequence = 0; // sequence number of the vehicle at begin
+        long lastExitTime = 0;      // mesoscopic model: stop line time of the last vehicle which has entered
+    };
+
+    // vehicle waiting for room at the start of the lanes of one driving direction
+    struct RoomRequest
+    {
+        std::shared_ptr<Vehicle> vehicle;
+        int firstLane;
+    };
+
+    // typical behaviour methods
+    int findLane(int first, double position); // lane of a driving direction with the most room behind the last vehicle, -1 if there is none
+    void notifyRoomRequests();                // called with the lanes locked whenever vehicles have moved or left
+    void updateLane(Lane &lane, double timeStep, double x1, double y1, double dx, double dy);
+    void updateQueue(Lane &lane, long time, double x1, double y1, double dx, double dy);
+    void toQueue(Lane &lane, long time);   // converts a lane from the microscopic to the mesoscopic model
+    void fromQueue(Lane &lane, long time); // converts a lane from the mesoscopic to the microscopic model
+    size_t getIndex(const LaneHandle &handle);
+    void resizeLanes();
+
     double _length;                                    // length of this street in m
+    int _lanes;                                        // number of lanes per driving direction
     std::shared_ptr<Intersection> _interIn, _interOut; // intersections from which a vehicle can enter (one-way streets is always from 'in' to 'out')
+    StreetModel _model;
+    CarFollowingParameters _parameters;
+    double _stopLine;
+    size_t _laneCapacity;                              // maximum number of vehicles per lane
+    std::vector<Lane> _laneVehicles;                   // lanes from 'in' to 'out' followed by lanes from 'out' to 'in'
+    std::vector<RoomRequest> _roomRequests;
+    std::mutex _mutex;                                 // protects the lanes
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "Street.h"
+#include "Metrics.h"
+#include "FrameSnapshot.h"
+#include "SimulationControl.h"
+#include "Tracer.h"
+#include "Trajectory.h"
+#include "StreetScheduler.h"
+
+/* Implementation of class "StreetScheduler" */
+
+StreetScheduler::StreetScheduler(long step)
+{
+    _nThreads = std::max(1u, std::thread::hardware_concurrency());
+    _pool.setThreads(_nThreads);
+    _step = step;
+    _isRunning = false;
+    _nSteps = 0;
+    _nVehicleUpdates = 0;
+    _stepTimer = TimingWheel::invalidTimer;
+}
+
+StreetScheduler::~StreetScheduler()
+{
+    stop();
+}
+
+void StreetScheduler::setStreets(std::vector<std::shared_ptr<Street>> &streets)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _streets = streets;
+}
+
+void StreetScheduler::setThreads(int nThreads)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _nThreads = nThreads > 0 ? nThreads : 1;
+    _pool.setThreads(_nThreads);
+}
+
+void StreetScheduler::setRecorder(std::shared_ptr<TrajectoryRecorder> recorder)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _recorder = recorder;
+}
+
+void StreetScheduler::setPublisher(std::shared_ptr<SnapshotPublisher> publisher)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _publisher = publisher;
+}
+
+void StreetScheduler::updateStreets()
+{
+    updateStreets(TrafficObject::getSimulationTime());
+}
+
+void StreetScheduler::updateStreets(long simulationTime)
+{
+    static Histogram &tickDuration = MetricsRegistry::getInstance().getHistogram("scheduler.tick_us");
+    TraceScope trace("updateStreets");
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto start = std::chrono::steady_clock::now();
+
+    // a checkpoint is not taken while vehicles move, see Checkpoint::capture
+    std::shared_lock<std::shared_mutex> stateLock(SimulationControl::getInstance().getStateMutex());
+
+    // every task updates a contiguous chunk of the streets, small networks are updated on the calling thread
+    double timeStep = _step / 1000.0;
+    size_t nStreets = _streets.size();
+    size_t nChunks = std::max<size_t>(1, std::min<size_t>(_nThreads, nStreets / minStreetsPerThread));
+    size_t chunkSize = (nStreets + nChunks - 1) / nChunks;
+
+    // a due trajectory frame is copied from every street right after its update, while its lanes are still
+    // in the cache. Every chunk fills a part of its own, which are merged afterwards.
+    std::vector<TrajectoryFrame> frameParts;
+    bool isRecording = _recorder && _recorder->beginFrame(simulationTime, frameParts, nChunks);
+    std::vector<size_t> nVehicles(nChunks, 0);
+    _pool.run(nChunks, [&](size_t chunk) {
+        for (size_t i = chunk * chunkSize, end = std::min(nStreets, i + chunkSize); i < end; ++i)
+        {
+            nVehicles[chunk] += _streets[i]->update(timeStep);
+            if (isRecording)
+            {
+                TrajectoryFrame &part = frameParts[chunk];
+                size_t count = _streets[i]->appendVehicleStates(part.vehicleIds, part.positions, part.speeds, part.states);
+                part.streetIds.insert(part.streetIds.end(), count, _streets[i]->getID());
+            }
+        }
+    });
+    if (isRecording)
+    {
+        _recorder->endFrame(frameParts);
+    }
+
+    // every street has been advanced by this step, so the frame does not mix positions of two steps
+    if (_publisher)
+    {
+        _publisher->publishFrame(simulationTime);
+    }
+    ++_nSteps;
+    for (size_t count : nVehicles)
+    {
+        _nVehicleUpdates += count;
+    }
+
+    tickDuration.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+void StreetScheduler::simulate()
+{
+    std::lock_guard<std::mutex> lock(_stepMutex);
+    _isRunning = true;
+    if (!_thread.joinable())
+    {
+        _thread = std::thread(&StreetScheduler::runSteps, this);
+    }
+    scheduleNextStep();
+}
+
+void StreetScheduler::scheduleNextStep()
+{
+    // the callback only hands the step over, so the timing wheel is never held up by the street updates
+    _stepTimer = TrafficObject::getTimingWheel().schedule(_step, [this]() {
+        std::lock_guard<std::mutex> lock(_stepMutex);
+        _dueSteps.push_back(TrafficObject::getSimulationTime());
+        _stepDue.notify_one();
+        if (_isRunning)
+        {
+            scheduleNextStep();
+        }
+    });
+}
+
+void StreetScheduler::runSteps()
+{
+    // steps which have fallen behind are run back to back, every one with the time at which it was due
+    Tracer::getInstance().setThreadName("StreetScheduler");
+    std::unique_lock<std::mutex> lock(_stepMutex);
+    while (true)
+    {
+        _stepDue.wait(lock, [this] { return !_dueSteps.empty() || !_isRunning; });
+        if (_dueSteps.empty())
+        {
+            break;
+        }
+        long simulationTime = _dueSteps.front();
+        _dueSteps.pop_front();
+        lock.unlock();
+
+        updateStreets(simulationTime);
+
+        lock.lock();
+    }
+}
+
+void StreetScheduler::stop()
+{
+    std::unique_lock<std::mutex> lock(_stepMutex);
+    _isRunning = false;
+    TimingWheel::TimerId timer = _stepTimer;
+    _stepTimer = TimingWheel::invalidTimer;
+    _stepDue.notify_all();
+    lock.unlock();
+
+    // a callback which is already running does not schedule the next step, but has to return before the object is destroyed
+    TrafficObject::getTimingWheel().cancelAndWait(timer);
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
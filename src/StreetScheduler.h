@@ -0,0 +1,70 @@
+#ifndef STREETSCHEDULER_H
+#define STREETSCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TimingWheel.h"
+#include "WorkerPool.h"
+
+// forward declarations to avoid include cycle
+class Street;
+class TrajectoryRecorder;
+class SnapshotPublisher;
+
+// advances the vehicles on all streets at a fixed step on the timing wheel. The timer callback only hands the
+// step to a thread of the scheduler, which splits the streets into chunks and updates them in parallel on a
+// persistent worker pool, as streets are independent of each other within a step.
+class StreetScheduler
+{
+public:
+    // constructor / desctructor
+    StreetScheduler(long step = 10);
+    ~StreetScheduler();
+
+    // getters / setters
+    void setStreets(std::vector<std::shared_ptr<Street>> &streets);
+    void setThreads(int nThreads); // before the scheduler is simulated
+    void setRecorder(std::shared_ptr<TrajectoryRecorder> recorder); // records the trajectories of the vehicles while updating the streets
+    void setPublisher(std::shared_ptr<SnapshotPublisher> publisher); // publishes a snapshot once all streets have been updated
+    long getStep() { return _step; }
+    long getSteps() { return _nSteps; }                   // steps since construction
+    long getVehicleUpdates() { return _nVehicleUpdates; } // vehicles advanced in all steps since construction
+
+    // typical behaviour methods
+    void updateStreets(); // advances all streets by one step on the calling thread and the worker pool
+    void simulate();
+    void stop(); // finishes the steps which have been due, so the scheduler can be destroyed afterwards
+
+private:
+    // typical behaviour methods
+    void scheduleNextStep();
+    void runSteps(); // executed in the step thread
+    void updateStreets(long simulationTime);
+
+    // private members
+    static constexpr size_t minStreetsPerThread = 64; // fewer streets are not worth starting a thread for
+
+    std::vector<std::shared_ptr<Street>> _streets;
+    std::shared_ptr<TrajectoryRecorder> _recorder;
+    std::shared_ptr<SnapshotPublisher> _publisher;
+    int _nThreads;
+    long _step;                                       // in ms
+    std::atomic<long> _nSteps, _nVehicleUpdates;
+    WorkerPool _pool;
+    std::mutex _mutex;                                // guards the streets, the recorder and the publisher, held during a step
+
+    // steps handed over by the timer
+    bool _isRunning;
+    TimingWheel::TimerId _stepTimer;
+    std::deque<long> _dueSteps;                       // simulation time of every step which has not been run yet
+    std::thread _thread;
+    std::condition_variable _stepDue;
+    std::mutex _stepMutex;                            // guards the members above
+};
+
+#endif
@@ -0,0 +1,368 @@
+#include <algorithm>
+#include "TimingWheel.h"
+
+/* Implementation of class "TimingWheel" */
+
+TimingWheel::TimingWheel(std::chrono::milliseconds tickDuration)
+{
+    _heads.fill(npos);
+    _freeList = npos;
+    _pending = 0;
+    _currentTick = 0;
+    _tickDuration = tickDuration;
+    _isRunning = false;
+    _isPaused = false;
+    _stepTicks = 0;
+    _nextFiring = 0;
+    _runningTimer = invalidTimer;
+}
+
+TimingWheel::~TimingWheel()
+{
+    stop();
+}
+
+size_t TimingWheel::getPending()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return _pending;
+}
+
+void TimingWheel::reserve(size_t nTimers)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // push additional nodes onto the free list so that schedule never has to grow the pool
+    size_t first = _nodes.size();
+    if (nTimers <= first)
+    {
+        return;
+    }
+    _nodes.resize(nTimers);
+    for (size_t i = nTimers; i-- > first;)
+    {
+        _nodes[i].list = npos;
+        _nodes[i].generation = 1;
+        _nodes[i].next = _freeList;
+        _freeList = static_cast<uint32_t>(i);
+    }
+}
+
+uint32_t TimingWheel::allocate()
+{
+    if (_freeList == npos)
+    {
+        // grow the pool by one node, the vector takes care of amortized growth
+        _nodes.emplace_back();
+        _nodes.back().generation = 1;
+        return static_cast<uint32_t>(_nodes.size() - 1);
+    }
+
+    uint32_t index = _freeList;
+    _freeList = _nodes[index].next;
+    return index;
+}
+
+void TimingWheel::release(uint32_t index)
+{
+    TimerNode &node = _nodes[index];
+    node.callback = nullptr;
+    node.list = npos;
+    node.next = _freeList;
+    _freeList = index;
+
+    // generation 0 is never used so that a valid timer id can never be equal to invalidTimer
+    if (++node.generation == 0)
+    {
+        node.generation = 1;
+    }
+}
+
+void TimingWheel::insert(uint32_t index)
+{
+    TimerNode &node = _nodes[index];
+    uint64_t now = _currentTick.load(std::memory_order_relaxed);
+
+    // pick the lowest level whose current window still contains the expiry tick
+    uint32_t list = overflowList;
+    if ((node.expiry >> rootBits) == (now >> rootBits))
+    {
+        list = node.expiry & ((1 << rootBits) - 1);
+    }
+    else
+    {
+        for (int level = 1; level < nLevels; ++level)
+        {
+            int shift = rootBits + level * levelBits;
+            if ((node.expiry >> shift) == (now >> shift))
+            {
+                uint64_t slot = (node.expiry >> (shift - levelBits)) & ((1 << levelBits) - 1);
+                list = (1 << rootBits) + (level - 1) * (1 << levelBits) + static_cast<uint32_t>(slot);
+                break;
+            }
+        }
+    }
+
+    // push node to the front of the slot list
+    node.list = list;
+    node.prev = npos;
+    node.next = _heads[list];
+    if (node.next != npos)
+    {
+        _nodes[node.next].prev = index;
+    }
+    _heads[list] = index;
+}
+
+void TimingWheel::unlink(uint32_t index)
+{
+    TimerNode &node = _nodes[index];
+    if (node.prev != npos)
+    {
+        _nodes[node.prev].next = node.next;
+    }
+    else
+    {
+        _heads[node.list] = node.next;
+    }
+    if (node.next != npos)
+    {
+        _nodes[node.next].prev = node.prev;
+    }
+}
+
+TimingWheel::TimerId TimingWheel::schedule(uint64_t delayTicks, Callback callback)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    uint32_t index = allocate();
+    TimerNode &node = _nodes[index];
+    node.callback = std::move(callback);
+    node.expiry = _currentTick.load(std::memory_order_relaxed) + (delayTicks > 0 ? delayTicks : 1);
+    insert(index);
+    ++_pending;
+
+    return (static_cast<TimerId>(node.generation) << 32) | index;
+}
+
+bool TimingWheel::cancel(TimerId id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    return cancelTimer(id);
+}
+
+bool TimingWheel::cancelAndWait(TimerId id)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (id == invalidTimer || cancelTimer(id))
+    {
+        return id != invalidTimer;
+    }
+
+    // a callback cancelling its own timer would wait for itself
+    if (_runningTimer == id && _runningThread != std::this_thread::get_id())
+    {
+        _callbackFinished.wait(lock, [this, id] { return _runningTimer != id; });
+    }
+    return false;
+}
+
+bool TimingWheel::cancelTimer(TimerId id)
+{
+    uint32_t index = static_cast<uint32_t>(id & 0xffffffff);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index < _nodes.size() && _nodes[index].list != npos && _nodes[index].generation == generation)
+    {
+        unlink(index);
+        release(index);
+        --_pending;
+        return true;
+    }
+
+    // the timer may have expired in the running advance without its callback having been started yet
+    for (size_t k = _nextFiring; k < _firing.size(); ++k)
+    {
+        if (_firing[k] == id)
+        {
+            _firing[k] = invalidTimer;
+            return true;
+        }
+    }
+    return false; // callback has already been started or the timer has been cancelled before
+}
+
+void TimingWheel::cascade(uint32_t list)
+{
+    // detach the whole slot and re-insert its nodes relative to the current tick
+    uint32_t index = _heads[list];
+    _heads[list] = npos;
+    while (index != npos)
+    {
+        uint32_t next = _nodes[index].next;
+        insert(index);
+        index = next;
+    }
+}
+
+void TimingWheel::tick(std::vector<std::pair<TimerId, Callback>> &expired)
+{
+    uint64_t now = _currentTick.load(std::memory_order_relaxed) + 1;
+    _currentTick.store(now, std::memory_order_release);
+
+    // whenever a lower level wraps around, move the timers of the next slot of the higher level(s) down.
+    // Higher levels are cascaded first so that their timers can still be distributed into the lower slots.
+    if ((now & ((1 << rootBits) - 1)) == 0)
+    {
+        int top = 1;
+        while (top < nLevels && (now & ((uint64_t(1) << (rootBits + top * levelBits)) - 1)) == 0)
+        {
+            ++top;
+        }
+        if (top == nLevels)
+        {
+            cascade(overflowList);
+        }
+        for (int level = std::min(top, nLevels - 1); level >= 1; --level)
+        {
+            uint64_t slot = (now >> (rootBits + (level - 1) * levelBits)) & ((1 << levelBits) - 1);
+            cascade((1 << rootBits) + (level - 1) * (1 << levelBits) + static_cast<uint32_t>(slot));
+        }
+    }
+
+    // all timers in the current slot of the lowest level expire now
+    uint32_t list = now & ((1 << rootBits) - 1);
+    uint32_t index = _heads[list];
+    _heads[list] = npos;
+    while (index != npos)
+    {
+        uint32_t next = _nodes[index].next;
+        expired.emplace_back((static_cast<TimerId>(_nodes[index].generation) << 32) | index, std::move(_nodes[index].callback));
+        release(index);
+        --_pending;
+        index = next;
+    }
+}
+
+size_t TimingWheel::advance(uint64_t ticks)
+{
+    std::vector<std::pair<TimerId, Callback>> expired;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (uint64_t i = 0; i < ticks; ++i)
+    {
+        tick(expired);
+    }
+    _firing.clear();
+    _nextFiring = 0;
+    for (auto &timer : expired)
+    {
+        _firing.push_back(timer.first);
+    }
+
+    // callbacks are run without holding the lock so that they can schedule or cancel timers themselves. Timers
+    // which are cancelled by an earlier callback of the same advance are skipped
+    size_t nFired = 0;
+    for (auto &timer : expired)
+    {
+        if (_firing[_nextFiring++] == invalidTimer)
+        {
+            continue;
+        }
+        _runningTimer = timer.first;
+        _runningThread = std::this_thread::get_id();
+        lock.unlock();
+
+        timer.second();
+
+        lock.lock();
+        _runningTimer = invalidTimer;
+        _callbackFinished.notify_all();
+        ++nFired;
+    }
+    _firing.clear();
+    _nextFiring = 0;
+
+    return nFired;
+}
+
+void TimingWheel::start()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (!_isRunning.exchange(true))
+    {
+        _thread = std::thread(&TimingWheel::run, this);
+    }
+}
+
+void TimingWheel::stop()
+{
+    bool wasRunning;
+    {
+        std::lock_guard<std::mutex> lock(_controlMutex);
+        wasRunning = _isRunning.exchange(false);
+        _controlCondition.notify_all();
+    }
+    if (wasRunning && _thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+void TimingWheel::pause()
+{
+    std::lock_guard<std::mutex> lock(_controlMutex);
+    _isPaused = true;
+}
+
+void TimingWheel::resume()
+{
+    std::lock_guard<std::mutex> lock(_controlMutex);
+    _isPaused = false;
+    _controlCondition.notify_all();
+}
+
+void TimingWheel::step(uint64_t ticks)
+{
+    std::lock_guard<std::mutex> lock(_controlMutex);
+    if (!_isPaused)
+    {
+        return; // a running wheel advances on its own
+    }
+    _stepTicks += ticks;
+    _controlCondition.notify_all();
+}
+
+void TimingWheel::run()
+{
+    // advance the wheel in real time, catching up on ticks which have been missed while callbacks were executed
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t ticksDone = 0;
+    while (_isRunning)
+    {
+        // a paused wheel only advances by the requested steps, the paused real time is not caught up on
+        if (_isPaused)
+        {
+            std::unique_lock<std::mutex> lock(_controlMutex);
+            _controlCondition.wait(lock, [this] { return !_isPaused || _stepTicks > 0 || !_isRunning; });
+            uint64_t ticks = _stepTicks;
+            _stepTicks = 0;
+            lock.unlock();
+
+            advance(ticks);
+            startTime = std::chrono::steady_clock::now() - _tickDuration * ticksDone;
+            continue;
+        }
+
+        std::this_thread::sleep_until(startTime + _tickDuration * (ticksDone + 1));
+
+        uint64_t ticksDue = (std::chrono::steady_clock::now() - startTime) / _tickDuration;
+        if (ticksDue > ticksDone)
+        {
+            advance(ticksDue - ticksDone);
+            ticksDone = ticksDue;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// hierarchical timing wheel (4 levels of 256/64/64/64 slots) with O(1) insert and cancel.
+// Timer nodes live in a pooled vector and are recycled through a free list, so memory only
+// grows with the peak number of pending timers. Callbacks are executed on the service thread
+// (or the thread calling advance) and must therefore be short and non-blocking. Objects whose
+// callbacks capture this have to cancel their timers with cancelAndWait before they are destroyed.
+class TimingWheel
+{
+public:
+    typedef uint64_t TimerId;               // generation in the upper 32 bits, pool index in the lower 32 bits
+    typedef std::function<void()> Callback;
+
+    static constexpr TimerId invalidTimer = 0;
+
+    // constructor / desctructor
+    TimingWheel(std::chrono::milliseconds tickDuration = std::chrono::milliseconds(1));
+    ~TimingWheel();
+
+    // getters / setters
+    uint64_t getCurrentTick() { return _currentTick.load(std::memory_order_acquire); }
+    std::chrono::milliseconds getTickDuration() { return _tickDuration; }
+    size_t getPending();
+    bool isPaused() { return _isPaused; }
+
+    // typical behaviour methods
+    TimerId schedule(uint64_t delayTicks, Callback callback); // fire callback after delayTicks (at least one) ticks
+    bool cancel(TimerId id);                                 // returns false if the callback has already started or the timer was cancelled
+    bool cancelAndWait(TimerId id);                          // like cancel, but waits for a running callback unless called from it
+    size_t advance(uint64_t ticks);                          // advance the wheel manually, returns the number of fired timers
+    void reserve(size_t nTimers);                            // preallocate timer nodes to avoid growing the pool later
+    void start();                                            // launch the service thread which advances the wheel in real time
+    void stop();
+    void pause();                                            // the service thread stops advancing the wheel
+    void resume();                                           // continues in real time from the current tick
+    void step(uint64_t ticks);                               // advances a paused wheel on the service thread
+
+private:
+    static constexpr uint32_t npos = 0xffffffff;
+    static constexpr int nLevels = 4;
+    static constexpr int rootBits = 8;    // 256 slots on the lowest level
+    static constexpr int levelBits = 6;   // 64 slots on every higher level
+    static constexpr int nSlots = (1 << rootBits) + (nLevels - 1) * (1 << levelBits);
+    static constexpr uint32_t overflowList = nSlots; // timers beyond the range of the highest level
+
+    struct TimerNode
+    {
+        Callback callback;
+        uint64_t expiry;
+        uint32_t prev, next;
+        uint32_t list;       // list the node is linked into, npos if the node is free
+        uint32_t generation; // incremented whenever the node is recycled so that stale ids can be detected
+    };
+
+    // typical behaviour methods
+    void run();
+    void tick(std::vector<std::pair<TimerId, Callback>> &expired);
+    bool cancelTimer(TimerId id); // called with _mutex held
+    void insert(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(uint32_t list);
+    uint32_t allocate();
+
+    // private members
+    std::vector<TimerNode> _nodes;                // pool of all timer nodes
+    std::array<uint32_t, nSlots + 1> _heads;      // head of the doubly linked list of every slot (+ overflow list)
+    uint32_t _freeList;                           // singly linked list of unused nodes (through TimerNode::next)
+    size_t _pending;                              // number of timers currently scheduled
+    std::atomic<uint64_t> _currentTick;           // ticks elapsed since the wheel has been created
+    std::chrono::milliseconds _tickDuration;
+    std::atomic<bool> _isRunning;
+    std::atomic<bool> _isPaused;
+    uint64_t _stepTicks;                          // ticks requested by step while the wheel is paused
+    std::vector<TimerId> _firing;                 // expired timers of the running advance, invalid once started or cancelled
+    size_t _nextFiring;                           // first entry of _firing whose callback has not been started yet
+    TimerId _runningTimer;                        // timer whose callback is being executed
+    std::thread::id _runningThread;
+    std::condition_variable _callbackFinished;
+    std::thread _thread;
+    std::mutex _mutex;
+    std::mutex _controlMutex;                     // protects the pause state, the service thread waits on it
+    std::condition_variable _controlCondition;
+};
+
+#endif
@@ -0,0 +1,178 @@
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include "Tracer.h"
+
+// events of one thread, stored in fixed-size chunks which are never moved. The owning thread appends without
+// locking, it only takes the mutex when it adds a chunk, which is also taken by the exporter.
+class TraceBuffer
+{
+public:
+    TraceBuffer(uint32_t thread) : _thread(thread) { addChunk(); }
+
+    uint32_t getThread() const { return _thread; }
+    void setName(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _name = name;
+    }
+    std::string getName()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _name;
+    }
+
+    void append(const TraceEvent &event)
+    {
+        Chunk *chunk = _current;
+        size_t size = chunk->size.load(std::memory_order_relaxed);
+        if (size == chunkSize)
+        {
+            chunk = addChunk();
+            size = 0;
+        }
+        chunk->events[size] = event;
+        chunk->size.store(size + 1, std::memory_order_release);
+    }
+
+    template <typename Visitor>
+    void visit(Visitor visitor)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &chunk : _chunks)
+        {
+            visitor(chunk->events.data(), chunk->size.load(std::memory_order_acquire));
+        }
+    }
+
+private:
+    static constexpr size_t chunkSize = 4096;
+
+    struct Chunk
+    {
+        std::array<TraceEvent, chunkSize> events;
+        std::atomic<size_t> size{0};
+    };
+
+    Chunk *addChunk()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _chunks.emplace_back(new Chunk());
+        _current = _chunks.back().get();
+        return _current;
+    }
+
+    std::vector<std::unique_ptr<Chunk>> _chunks;
+    Chunk *_current;
+    std::string _name;
+    uint32_t _thread;
+    std::mutex _mutex;
+};
+
+// writes the string as a JSON string literal, thread names are chosen freely by the threads
+static void writeJsonString(std::ostream &out, const std::string &text)
+{
+    out << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out << escaped;
+        }
+        else
+        {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+/* Implementation of class "Tracer" */
+
+Tracer::Tracer()
+{
+    _isEnabled = false;
+}
+
+Tracer &Tracer::getInstance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+TraceBuffer &Tracer::getThreadBuffer()
+{
+    // the tracer keeps the buffer alive after the thread has exited, so its events can still be exported
+    thread_local std::shared_ptr<TraceBuffer> buffer;
+    if (!buffer)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        buffer = std::make_shared<TraceBuffer>(static_cast<uint32_t>(_buffers.size()) + 1);
+        _buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void Tracer::setThreadName(const std::string &name)
+{
+    if (isEnabled())
+    {
+        getThreadBuffer().setName(name);
+    }
+}
+
+void Tracer::record(const TraceEvent &event)
+{
+    getThreadBuffer().append(event);
+}
+
+bool Tracer::writeChromeTrace(const std::string &filename)
+{
+    std::ofstream file(filename);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        buffers = _buffers;
+    }
+
+    // complete events ("X") with timestamps in microseconds, plus the names of the threads
+    file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+    bool isFirst = true;
+    for (auto &buffer : buffers)
+    {
+        uint32_t thread = buffer->getThread();
+        std::string name = buffer->getName();
+        if (!name.empty())
+        {
+            file << (isFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+                 << ",\"args\":{\"name\":";
+            writeJsonString(file, name);
+            file << "}}";
+            isFirst = false;
+        }
+        buffer->visit([&](const TraceEvent *events, size_t nEvents) {
+            for (size_t i = 0; i < nEvents; ++i)
+            {
+                const TraceEvent &event = events[i];
+                file << (isFirst ? "" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":"
+                     << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << ",\"pid\":1,\"tid\":" << thread << "}";
+                isFirst = false;
+            }
+        });
+    }
+    file << "\n]}\n";
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,96 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// completed time span on one thread, names and categories are string literals
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    int64_t start;    // steady clock in ns
+    int64_t duration; // in ns
+};
+
+// forward declaration, the per-thread event buffers are private to the tracer
+class TraceBuffer;
+
+// records time spans of all threads into per-thread buffers and exports them in the Chrome trace event format,
+// which can be opened in chrome://tracing or Perfetto. Recording is disabled by default and then only costs
+// a relaxed load per scope.
+class Tracer
+{
+public:
+    // getters / setters
+    static Tracer &getInstance();
+    void setEnabled(bool isEnabled) { _isEnabled.store(isEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const { return _isEnabled.load(std::memory_order_relaxed); }
+    void setThreadName(const std::string &name); // shown for the calling thread in the timeline
+
+    // typical behaviour methods
+    void record(const TraceEvent &event);
+    bool writeChromeTrace(const std::string &filename); // returns false if the file could not be written
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    // constructor / desctructor
+    Tracer();
+
+    // typical behaviour methods
+    TraceBuffer &getThreadBuffer();
+
+    // private members
+    std::atomic<bool> _isEnabled;
+    std::vector<std::shared_ptr<TraceBuffer>> _buffers; // buffers of all threads which have recorded events
+    std::mutex _mutex;
+};
+
+// records the lifetime of the scope as one event while tracing is enabled
+class TraceScope
+{
+public:
+    TraceScope(const char *name, const char *category = "sim")
+    {
+        _event.name = name;
+        _event.category = category;
+        _event.start = Tracer::getInstance().isEnabled() ? Tracer::now() : -1;
+    }
+
+    ~TraceScope()
+    {
+        if (_event.start >= 0)
+        {
+            _event.duration = Tracer::now() - _event.start;
+            Tracer::getInstance().record(_event);
+        }
+    }
+
+private:
+    TraceEvent _event;
+};
+
+// acquires a lock and records the time spent waiting for it, if it has been held by another thread
+template <typename Lock>
+void lockWithTrace(Lock &lock, const char *name)
+{
+    if (lock.try_lock())
+    {
+        return;
+    }
+
+    TraceScope trace(name, "lock");
+    lock.lock();
+}
+
+#endif
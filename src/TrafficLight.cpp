@@ -1,135 +1,227 @@
 #include <iostream>
 #include <random>
 #include "TrafficLight.h"
+#include "Metrics.h"
+#include "Tracer.h"
 #include <future>
 
-/* Implementation of class "MessageQueue" */
+/* Implementation of class "TrafficLight" */
+TrafficLight::TrafficLight()
+{
+    _currentPhase = TrafficLightPhase::red;
+    _greenMask = 0;
+    _isSimulating = false;
+    _isActuated = false;
+    _phaseIndex = 0;
+    _phaseStart = -1;
+    _cycleTimer = TimingWheel::invalidTimer;
+    _cycleGeneration = 0;
+}
 
-template <typename T>
-T MessageQueue<T>::receive()
+TrafficLight::~TrafficLight()
 {
-    // FP.5a : The method receive should use std::unique_lock<std::mutex> and _condition.wait() 
-    // to wait for and receive new messages and pull them from the queue using move semantics. 
-    // The received object should then be returned by the receive function. 
+    // make sure that the timer does not fire on a destroyed object and that a running callback has returned
     std::unique_lock<std::mutex> lck(_mutex);
-    //a Lambda to wait(), which repeatedly checks wether the queue contains elements. When wait() finishes, we are guaranteed to 
-    //find a new element in the queue this time. when wait state is entered, the mutex gets unlocked, so all the threads have access
-    //to the queue. Once out of wait condition, mutex gets locked again, no other thread is able to access the vector - 
-    //so there is no danger of a data race in this situation. As soon as we are out of scope, the lock will be automatically released.
-    _cond.wait(lck, [this] { return !_queue.empty(); });
+    cancelCycleTimer(lck);
+}
 
-    // remove last element from queue
-    T msg = std::move(_queue.back());
-    _queue.pop_back();
+void TrafficLight::waitForGreen(int approach)
+{
+    // FP.5b : block until the approach has right of way. The phase timer notifies all waiting vehicles
+    // on every phase change, so vehicles on different approaches can wait at the same time.
+    TraceScope trace("waitForGreen");
+    std::unique_lock<std::mutex> lck(_mutex);
+    _condition.wait(lck, [this, approach] { return (_greenMask & (uint64_t(1) << approach)) != 0 || _isStopping; });
+}
 
-    // will not be copied due to return value optimization (RVO) in C++
-    return msg;
+TrafficLightPhase TrafficLight::getCurrentPhase()
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    return _currentPhase;
 }
 
-template <typename T>
-void MessageQueue<T>::send(T &&msg)
+TrafficLightPhase TrafficLight::getCurrentPhase(int approach)
 {
-    // FP.4a : The method send should use the mechanisms std::lock_guard<std::mutex> 
-    // as well as _condition.notify_one() to add a new message to the queue and afterwards send a notification.
-    // Add lock guard for automatic locking and unlocking
     std::lock_guard<std::mutex> lck(_mutex);
+    return (_greenMask & (uint64_t(1) << approach)) != 0 ? green : red;
+}
 
-    //Push messages to the queue
-    _queue.emplace_back(std::move(msg));
+void TrafficLight::setSignalPlan(const SignalPlan &plan)
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    _plan = plan;
+
+    // a running light switches to the new plan immediately
+    if (_isSimulating && _isActuated)
+    {
+        _phaseIndex = _plan.isEmpty() ? 0 : _phaseIndex % _plan.getPhaseCount();
+        _greenMask = _plan.isEmpty() ? ~uint64_t(0) : _plan.getPhase(_phaseIndex).greenMask;
+        _currentPhase = _greenMask != 0 ? green : red;
+        _condition.notify_all();
+    }
+    else if (_isSimulating)
+    {
+        cancelCycleTimer(lck);
+        scheduleNextPhase();
+    }
+}
 
-    // notify client each time a msg is pushed into queue
-    _cond.notify_one();
+SignalPlan TrafficLight::getSignalPlan()
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    return _plan;
+}
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+void TrafficLight::setActuated(bool isActuated)
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    if (_isActuated == isActuated)
+    {
+        return;
+    }
+    _isActuated = isActuated;
+
+    // stop the plan timer and keep the active phase, or resume the plan timing
+    if (_isSimulating)
+    {
+        cancelCycleTimer(lck);
+        if (!_isActuated)
+        {
+            scheduleNextPhase();
+        }
+    }
 }
 
-/* Implementation of class "TrafficLight" */
-TrafficLight::TrafficLight()
+void TrafficLight::restorePhase(size_t phaseIndex, long phaseStart)
 {
-    _currentPhase = TrafficLightPhase::red;
+    std::lock_guard<std::mutex> lck(_mutex);
+    _phaseIndex = phaseIndex;
+    _phaseStart = phaseStart;
 }
 
-void TrafficLight::waitForGreen()
+size_t TrafficLight::getPhaseIndex()
 {
-    // FP.5b : add the implementation of the method waitForGreen, in which an infinite while-loop 
-    // runs and repeatedly calls the receive function on the message queue. 
-    // Once it receives TrafficLightPhase::green, the method returns.
+    std::lock_guard<std::mutex> lck(_mutex);
+    return _phaseIndex;
+}
 
-    while (true) {
+long TrafficLight::getTimeInPhase()
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    return getSimulationTime() - _phaseStart;
+}
+
+void TrafficLight::getState(SignalPlan &plan, size_t &phaseIndex, long &phaseStart)
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    plan = _plan;
+    phaseIndex = _phaseIndex;
+    phaseStart = _phaseStart;
+}
+
+void TrafficLight::advancePhase()
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    if (!_isActuated || _plan.isEmpty())
+    {
+        return;
+    }
+
+    // switch to the next phase of the plan and release all vehicles which now have right of way
+    recordPhaseDuration();
+    _phaseIndex = (_phaseIndex + 1) % _plan.getPhaseCount();
+    _phaseStart = getSimulationTime();
+    _greenMask = _plan.getPhase(_phaseIndex).greenMask;
+    _currentPhase = _greenMask != 0 ? green : red;
+    _condition.notify_all();
+}
 
-        /* Sleep at every iteration to reduce CPU usage */
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+void TrafficLight::simulate()
+{
+    // FP.2b : Finally, the private method „cycleThroughPhases“ should be started when the public method „simulate“ is called.
+    // Instead of polling in a thread of its own, every phase change is scheduled on the shared timing wheel.
+    std::lock_guard<std::mutex> lck(_mutex);
 
-        TrafficLightPhase msg = _msg_queue->receive();
+    // without a configured plan, all approaches toggle between red and green with a random duration between 4 and 6 seconds
+    if (_plan.isEmpty())
+    {
+        std::minstd_rand engine(std::random_device{}());
+        std::uniform_int_distribution<> distr(4000, 6000);
+        _plan.addPhase(distr(engine), 0);
+        _plan.addPhase(distr(engine), ~uint64_t(0));
+    }
 
-        if (msg == green) {
-            return;
+    _isSimulating = true;
+    if (_isActuated)
+    {
+        // start in the first phase, unless a phase has been restored
+        _phaseIndex %= _plan.getPhaseCount();
+        if (_phaseStart < 0)
+        {
+            _phaseStart = getSimulationTime();
         }
+        _greenMask = _plan.getPhase(_phaseIndex).greenMask;
+        _currentPhase = _greenMask != 0 ? green : red;
+    }
+    else
+    {
+        scheduleNextPhase();
     }
 }
 
-TrafficLightPhase TrafficLight::getCurrentPhase()
+void TrafficLight::stop()
 {
-    return _currentPhase;
+    std::unique_lock<std::mutex> lck(_mutex);
+    _isStopping = true;
+    _condition.notify_all();
+    cancelCycleTimer(lck);
 }
 
-void TrafficLight::simulate()
+void TrafficLight::cancelCycleTimer(std::unique_lock<std::mutex> &lck)
 {
-    // FP.2b : Finally, the private method „cycleThroughPhases“ should be started in a thread 
-    //when the public method „simulate“ is called. To do this, use the thread queue in the base class. 
-    threads.emplace_back(std::thread(&TrafficLight::cycleThroughPhases, this));
- }
-
-/* virtual function which is executed in a thread */
-void TrafficLight::cycleThroughPhases()
-{
-    // FP.2a : Implement the function with an infinite loop that measures the time between two loop cycles 
-    // and toggles the current phase of the traffic light between red and green and sends an update method 
-    // to the message queue using move semantics. The cycle duration should be a random value between 4 and 6 seconds. 
-    // Also, the while-loop should use std::this_thread::sleep_for to wait 1ms between two cycles.
-
-    // Variables to get the time difference between two loop cycles
-    long timeSinceLastUpdate{};
-    std::chrono::time_point<std::chrono::system_clock> lastUpdate;
-
-    // Get the random duration cycle between 4 and 6
-    std::random_device rd;
-    std::mt19937 eng(rd());
-    std::uniform_int_distribution<> distr(4, 6);
-    int cycle_duration = distr(eng);    
-
-    // Get the current value of time
-    lastUpdate = std::chrono::system_clock::now();
-
-    while (true) {
-        // Sleep for 1 milliseonds
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-        // Get the time difference between two loop cycles
-        timeSinceLastUpdate = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() 
-            - lastUpdate).count();
-
-        // Check if time difference is greater than cycle duration
-        if (timeSinceLastUpdate >= cycle_duration) {
-
-            //Toggle between red and green light
-            if (_currentPhase == green) {
-                _currentPhase = red;
-            }
-            else {
-                _currentPhase = green;
-            }
-
-            // Send message to the thread which is the current phase of the traffic light using async
-            std::future<void> update_phase_ftr = std::async(std::launch::async, &MessageQueue<TrafficLightPhase>::send, 
-                _msg_queue, std::move(_currentPhase));
-
-            // Future waits to recieve data 
-            update_phase_ftr.wait();
-        }
+    // a callback which has already been taken off the wheel may be waiting for the lock, so the lock is released
+    // while waiting for it. The callback then finds a newer generation and returns without changing the phase
+    TimingWheel::TimerId timer = _cycleTimer;
+    _cycleTimer = TimingWheel::invalidTimer;
+    ++_cycleGeneration;
+    lck.unlock();
+    getTimingWheel().cancelAndWait(timer);
+    lck.lock();
+}
 
-        // Reset the last update variable at the end of the cycle 
-        lastUpdate = std::chrono::system_clock::now();
+void TrafficLight::scheduleNextPhase()
+{
+    // look up the active phase in the plan and schedule a timer for the next phase change
+    long now = getSimulationTime();
+    _greenMask = _plan.greenMaskAt(now);
+    _currentPhase = _greenMask != 0 ? green : red;
+    _condition.notify_all();
+
+    long nextChange = _plan.nextChangeAt(now);
+    if (nextChange >= 0)
+    {
+        _phaseIndex = _plan.phaseAt(now);
+        _phaseStart = nextChange - _plan.getPhase(_phaseIndex).duration;
+        uint64_t generation = ++_cycleGeneration;
+        _cycleTimer = scheduleTimer(nextChange - now, [this, generation]() { cycleThroughPhases(generation); });
+    }
+}
+
+/* timer callback which is executed on the timing wheel thread */
+void TrafficLight::cycleThroughPhases(uint64_t generation)
+{
+    // FP.2a : Switch to the next phase of the signal plan and notify all vehicles waiting for green.
+    std::lock_guard<std::mutex> lck(_mutex);
+    if (_isStopping || generation != _cycleGeneration)
+    {
+        return; // the timer has fired while the light was stopped or its timer was replaced
     }
+    recordPhaseDuration();
+    scheduleNextPhase();
 }
 
+void TrafficLight::recordPhaseDuration()
+{
+    static Histogram &phaseDuration = MetricsRegistry::getInstance().getHistogram("trafficlight.phase_ms");
+    phaseDuration.record(getSimulationTime() - _phaseStart);
+}
@@ -4,7 +4,9 @@
 #include <mutex>
 #include <deque>
 #include <condition_variable>
+#include <random>
 #include "TrafficObject.h"
+#include "SignalPlan.h"
 
 enum TrafficLightPhase {
     red,
@@ -33,11 +35,49 @@ private:
     std::condition_variable _cond;    
 };
 
+// the implementation is in the header, so the queue can be instantiated for any message type
+template <typename T>
+T MessageQueue<T>::receive()
+{
+    // FP.5a : The method receive should use std::unique_lock<std::mutex> and _condition.wait() 
+    // to wait for and receive new messages and pull them from the queue using move semantics. 
+    // The received object should then be returned by the receive function. 
+    std::unique_lock<std::mutex> lck(_mutex);
+    //a Lambda to wait(), which repeatedly checks wether the queue contains elements. When wait() finishes, we are guaranteed to 
+    //find a new element in the queue this time. when wait state is entered, the mutex gets unlocked, so all the threads have access
+    //to the queue. Once out of wait condition, mutex gets locked again, no other thread is able to access the vector - 
+    //so there is no danger of a data race in this situation. As soon as we are out of scope, the lock will be automatically released.
+    _cond.wait(lck, [this] { return !_queue.empty(); });
+
+    // remove last element from queue
+    T msg = std::move(_queue.back());
+    _queue.pop_back();
+
+    // will not be copied due to return value optimization (RVO) in C++
+    return msg;
+}
+
+template <typename T>
+void MessageQueue<T>::send(T &&msg)
+{
+    // FP.4a : The method send should use the mechanisms std::lock_guard<std::mutex> 
+    // as well as _condition.notify_one() to add a new message to the queue and afterwards send a notification.
+    // Add lock guard for automatic locking and unlocking
+    std::lock_guard<std::mutex> lck(_mutex);
+
+    //Push messages to the queue
+    _queue.emplace_back(std::move(msg));
+
+    // notify client each time a msg is pushed into queue
+    _cond.notify_one();
+}
+
 // FP.1 : Define a class „TrafficLight“ which is a child class of TrafficObject. 
 // The class shall have the public methods „void waitForGreen()“ and „void simulate()“ 
 // as well as „TrafficLightPhase getCurrentPhase()“, where TrafficLightPhase is an enum that 
 // can be either „red“ or „green“. Also, add the private method „void cycleThroughPhases()“. 
 // Furthermore, there shall be the private member _currentPhase which can take „red“ or „green“ as its value. 
+// The phases are driven by a SignalPlan, so every approach of the intersection can have its own phase.
 
 class TrafficLight : public TrafficObject
 {
@@ -46,27 +86,43 @@ public:
     TrafficLight();
 
     //destructor
-    ~TrafficLight() {};
+    ~TrafficLight();
 
     // getters / setters
-    TrafficLightPhase getCurrentPhase();
+    TrafficLightPhase getCurrentPhase();             // green if at least one approach has right of way
+    TrafficLightPhase getCurrentPhase(int approach);
+    void setSignalPlan(const SignalPlan &plan);
+    SignalPlan getSignalPlan();
+    void setActuated(bool isActuated);               // in actuated mode phases only change when advancePhase is called
+    void restorePhase(size_t phaseIndex, long phaseStart); // actuated mode: phase in which the light starts when simulated
+    size_t getPhaseIndex();
+    long getTimeInPhase();                           // in ms
+    void getState(SignalPlan &plan, size_t &phaseIndex, long &phaseStart); // all under one lock, for checkpoints
 
     // typical behaviour methods
-    void waitForGreen();
+    void waitForGreen(int approach);
+    void advancePhase();
     void simulate();
+    void stop(); // cancels the phase timer and releases all vehicles waiting for green
 
 private:
     // typical behaviour methods
-    void cycleThroughPhases();
+    void cycleThroughPhases(uint64_t generation);
+    void scheduleNextPhase();
+    void cancelCycleTimer(std::unique_lock<std::mutex> &lck); // releases the lock while waiting for a running callback
+    void recordPhaseDuration(); // called with _mutex held before the phase changes
 
-    // FP.4b : create a private member of type MessageQueue for messages of type TrafficLightPhase 
-    // and use it within the infinite loop to push each new TrafficLightPhase into it by calling 
-    // send in conjunction with move semantics.
-    std::shared_ptr<MessageQueue<TrafficLightPhase>> _msg_queue = std::make_shared<MessageQueue<TrafficLightPhase>>();
     std::condition_variable _condition;
     std::mutex _mutex;
     TrafficLightPhase _currentPhase;
-
+    uint64_t _greenMask;              // approaches which currently have right of way
+    SignalPlan _plan;                 // plan which determines the phase of every approach
+    bool _isSimulating;               // true once simulate has been called
+    bool _isActuated;                 // phases are switched by a SignalController instead of the plan timing
+    size_t _phaseIndex;               // currently active phase of the plan
+    long _phaseStart;                 // simulation time at which the active phase started, negative until simulated
+    TimingWheel::TimerId _cycleTimer; // pending timer of the next phase change
+    uint64_t _cycleGeneration;        // incremented whenever the timer is replaced, older callbacks are ignored
 };
 
 #endif
\ No newline at end of file
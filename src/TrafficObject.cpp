@@ -4,26 +4,95 @@
 #include "TrafficObject.h"
 
 // init static variable
-int TrafficObject::_idCnt = 0;
+std::atomic<int> TrafficObject::_idCnt(0);
+std::atomic<long> TrafficObject::_timeOffset(0);
 
-std::mutex TrafficObject::_mtx;
 
 void TrafficObject::setPosition(double x, double y)
 {
-    _posX = x;
-    _posY = y;
+    // the position has a single writer, readers retry while the version is odd or has changed
+    unsigned version = _posVersion.load(std::memory_order_relaxed);
+    _posVersion.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _posX.store(x, std::memory_order_relaxed);
+    _posY.store(y, std::memory_order_relaxed);
+    _posVersion.store(version + 2, std::memory_order_release);
 }
 
 void TrafficObject::getPosition(double &x, double &y)
 {
-    x = _posX;
-    y = _posY;
+    unsigned version;
+    do
+    {
+        version = _posVersion.load(std::memory_order_acquire);
+        x = _posX.load(std::memory_order_relaxed);
+        y = _posY.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((version & 1) || version != _posVersion.load(std::memory_order_relaxed));
 }
 
-TrafficObject::TrafficObject()
+TimingWheel &TrafficObject::getTimingWheel()
+{
+    // the wheel is created and started on first use
+    static TimingWheel &timingWheel = []() -> TimingWheel & {
+        static TimingWheel wheel(std::chrono::milliseconds(1));
+        wheel.start();
+        return wheel;
+    }();
+
+    return timingWheel;
+}
+
+long TrafficObject::getSimulationTime()
+{
+    TimingWheel &timingWheel = getTimingWheel();
+    return _timeOffset.load(std::memory_order_relaxed) + static_cast<long>(timingWheel.getCurrentTick() * timingWheel.getTickDuration().count());
+}
+
+void TrafficObject::setSimulationTime(long time)
+{
+    // timers are scheduled relative to the current tick, so only absolute times are shifted
+    _timeOffset = time - (getSimulationTime() - _timeOffset);
+}
+
+TimingWheel::TimerId TrafficObject::scheduleTimer(long delayMs, TimingWheel::Callback callback)
+{
+    TimingWheel &timingWheel = getTimingWheel();
+    uint64_t delayTicks = delayMs > 0 ? delayMs / timingWheel.getTickDuration().count() : 0;
+
+    return timingWheel.schedule(delayTicks, std::move(callback));
+}
+
+void TrafficObject::stop()
+{
+    _isStopping = true;
+    joinThreads();
+}
+
+void TrafficObject::joinThreads()
+{
+    for (auto &t : _threads)
+    {
+        if (t.joinable())
+        {
+            t.join();
+        }
+    }
+}
+
+int TrafficObject::reserveIDs(int n)
+{
+    return _idCnt.fetch_add(n);
+}
+
+TrafficObject::TrafficObject(int id)
 {
     _type = ObjectType::noObject;
-    _id = _idCnt++;
+    _id = id == newID ? _idCnt++ : id;
+    _posX = 0.0;
+    _posY = 0.0;
+    _posVersion = 0;
+    _isStopping = false;
 }
 
 TrafficObject::~TrafficObject()
@@ -31,6 +100,7 @@ TrafficObject::~TrafficObject()
     // Task L1.1 : Set up a thread barrier that ensures that all the thread objects in the member vector _threads are joined.
     // Join makes sure that all the threads are termonated before the main function exits
     for (auto& t : _threads) {
-        t.join();
+        if (t.joinable())
+            t.join();
     }
 }
@@ -2,8 +2,11 @@
 #define TRAFFICOBJECT_H
 
 #include <vector>
+#include <atomic>
 #include <thread>
 #include <mutex>
+#include <memory>
+#include "TimingWheel.h"
 
 enum ObjectType
 {
@@ -16,8 +19,10 @@ enum ObjectType
 class TrafficObject
 {
 public:
+    static constexpr int newID = -1; // takes the next free id, otherwise the id must have been taken from reserveIDs
+
     // constructor / desctructor
-    TrafficObject();
+    TrafficObject(int id = newID);
     ~TrafficObject();
 
     // getter and setter
@@ -25,23 +30,40 @@ public:
     int getID() { return _id; }
     //set the position of the vehicle
     void setPosition(double x, double y);
-    // Get the position of the vehicle
+    // Get the position of the vehicle, never returns a partially updated position
     void getPosition(double &x, double &y);
     // Get the type of traffic object : vehicle, intersections, street, traffic lights
     ObjectType getType() { return _type; }
 
     // typical behaviour methods
     virtual void simulate(){};
+    virtual void stop(); // lets all threads of the object finish and joins them
+
+    // reserves n consecutive ids and returns the first, so that objects created in parallel get ids in the order of their index
+    static int reserveIDs(int n);
+
+    // timer service shared by all traffic objects, one tick corresponds to one millisecond
+    static TimingWheel &getTimingWheel();
+    // simulation time in ms, measured by the shared timing wheel
+    static long getSimulationTime();
+    // moves the simulation clock to the given time in ms, used to resume from a checkpoint before any object is simulated
+    static void setSimulationTime(long time);
 
 protected:
     ObjectType _type;                 // identifies the class type
     int _id;                          // every traffic object has its own unique id
-    double _posX, _posY;              // vehicle position in pixels
-    std::vector<std::thread> threads; // holds all threads that have been launched within this object
-    static std::mutex _mtx;           // mutex shared by all traffic objects for protecting cout 
+    std::atomic<double> _posX, _posY;  // vehicle position in pixels
+    std::atomic<unsigned> _posVersion; // sequence lock for the position, odd while an update is in progress
+    std::vector<std::thread> _threads; // holds all threads that have been launched within this object
+    std::atomic<bool> _isStopping;     // checked by all loops of the object's threads
+
+    // schedule a callback on the shared timing wheel, the callback is executed on the timer thread
+    TimingWheel::TimerId scheduleTimer(long delayMs, TimingWheel::Callback callback);
+    void joinThreads();
 
 private:
-    static int _idCnt; // global variable for counting object ids
+    static std::atomic<int> _idCnt; // global variable for counting object ids, objects may be created in parallel
+    static std::atomic<long> _timeOffset; // simulation time in ms at tick 0 of the timing wheel
 };
 
 #endif
\ No newline at end of file
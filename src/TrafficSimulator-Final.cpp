@@ -1,116 +1,123 @@
 #include <iostream>
+#include <algorithm>
 #include <thread>
 #include <vector>
+#include <string>
+#include <cstdio>
 
 #include "Vehicle.h"
 #include "Street.h"
 #include "Intersection.h"
+#include "Networks.h"
+#include "Checkpoint.h"
+#include "SignalController.h"
 #include "Graphics.h"
+#include "FrameSnapshot.h"
+#include "StreetScheduler.h"
+#include "FidelityRegions.h"
+#include "Metrics.h"
+#include "Trajectory.h"
+#include "Replay.h"
+#include "Logger.h"
+#include "SimulationControl.h"
+#include "Tracer.h"
 
 
-// Paris
-void createTrafficObjects_Paris(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles, std::string &filename, int nVehicles)
+/* Main function */
+int main(int argc, char *argv[])
 {
-    // assign filename of corresponding city map
-    filename = "../data/paris.jpg";
-
-    // init traffic objects
-    int nIntersections = 9;
-    for (size_t ni = 0; ni < nIntersections; ni++)
+    // log level of the simulation, per-vehicle events are logged at debug level: --log-level <debug|info|warning|error|off>
+    for (int i = 1; i + 1 < argc; i++)
     {
-        intersections.push_back(std::make_shared<Intersection>());
+        LogLevel level;
+        if (std::string(argv[i]) == "--log-level" && Logger::parseLevel(argv[++i], level))
+        {
+            Logger::getInstance().setLevel(level);
+        }
     }
 
-    // position intersections in pixel coordinates (counter-clockwise)
-    intersections.at(0)->setPosition(385, 270);
-    intersections.at(1)->setPosition(1240, 80);
-    intersections.at(2)->setPosition(1625, 75);
-    intersections.at(3)->setPosition(2110, 75);
-    intersections.at(4)->setPosition(2840, 175);
-    intersections.at(5)->setPosition(3070, 680);
-    intersections.at(6)->setPosition(2800, 1400);
-    intersections.at(7)->setPosition(400, 1100);
-    intersections.at(8)->setPosition(1700, 900); // central plaza
-
-    // create streets and connect traffic objects
-    int nStreets = 8;
-    for (size_t ns = 0; ns < nStreets; ns++)
+    // record a timeline of all threads during the first 10 s of simulation time: --trace <file>
+    // the export is written by a thread of its own, so the timing wheel does not stall while the file is written
+    std::string traceFile;
+    TimingWheel::TimerId traceTimer = TimingWheel::invalidTimer;
+    std::thread traceWriter;
+    for (int i = 1; i + 1 < argc; i++)
     {
-        streets.push_back(std::make_shared<Street>());
-        streets.at(ns)->setInIntersection(intersections.at(ns));
-        streets.at(ns)->setOutIntersection(intersections.at(8));
+        if (std::string(argv[i]) == "--trace")
+        {
+            traceFile = argv[++i];
+            Tracer::getInstance().setEnabled(true);
+            TrafficObject::getTimingWheel().cancel(traceTimer);
+            traceTimer = TrafficObject::getTimingWheel().schedule(10000, [traceFile, &traceWriter]() {
+                Tracer::getInstance().setEnabled(false);
+                traceWriter = std::thread([traceFile]() { Tracer::getInstance().writeChromeTrace(traceFile); });
+            });
+        }
     }
 
-    // add vehicles to streets
-    for (size_t nv = 0; nv < nVehicles; nv++)
+    // render offscreen into a video file on headless machines: --video <file> [--fps <fps>] [--size <width>x<height>]
+    // write a snapshot of all metrics every second of simulation time: --metrics <file>
+    std::string videoFile, metricsFile;
+    double fps = 30.0;
+    int width = 0, height = 0;
+    for (int i = 1; i + 1 < argc; i++)
     {
-        vehicles.push_back(std::make_shared<Vehicle>());
-        vehicles.at(nv)->setCurrentStreet(streets.at(nv));
-        vehicles.at(nv)->setCurrentDestination(intersections.at(8));
+        std::string arg = argv[i];
+        if (arg == "--video")
+            videoFile = argv[++i];
+        else if (arg == "--fps")
+        {
+            if (std::sscanf(argv[++i], "%lf", &fps) != 1 || !(fps > 0.0))
+            {
+                Logger::getInstance().log(logError, "--fps expects a positive number, 30 frames per second are used");
+                fps = 30.0;
+            }
+        }
+        else if (arg == "--size")
+        {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+            {
+                Logger::getInstance().log(logError, "--size expects <width>x<height>, the size of the map is used");
+                width = height = 0;
+            }
+        }
+        else if (arg == "--metrics")
+            metricsFile = argv[++i];
     }
-}
-
-// NYC
-void createTrafficObjects_NYC(std::vector<std::shared_ptr<Street>> &streets, std::vector<std::shared_ptr<Intersection>> &intersections, std::vector<std::shared_ptr<Vehicle>> &vehicles, std::string &filename, int nVehicles)
-{
-    // assign filename of corresponding city map
-    filename = "../data/nyc.jpg";
 
-    // init traffic objects
-    int nIntersections = 6;
-    for (size_t ni = 0; ni < nIntersections; ni++)
+    // play back a replay log instead of simulating, the view options above apply: --replay <file>
+    // record the drawn frames every 100 ms of simulation time for playback: --record <file>
+    std::string replayFile, recordFile;
+    for (int i = 1; i + 1 < argc; i++)
     {
-        intersections.push_back(std::make_shared<Intersection>());
+        std::string arg = argv[i];
+        if (arg == "--replay")
+            replayFile = argv[++i];
+        else if (arg == "--record")
+            recordFile = argv[++i];
     }
-
-    // position intersections in pixel coordinates
-    intersections.at(0)->setPosition(1430, 625);
-    intersections.at(1)->setPosition(2575, 1260);
-    intersections.at(2)->setPosition(2200, 1950);
-    intersections.at(3)->setPosition(1000, 1350);
-    intersections.at(4)->setPosition(400, 1000);
-    intersections.at(5)->setPosition(750, 250);
-
-    // create streets and connect traffic objects
-    int nStreets = 7;
-    for (size_t ns = 0; ns < nStreets; ns++)
+    if (!replayFile.empty())
     {
-        streets.push_back(std::make_shared<Street>());
+        auto replay = std::make_shared<ReplayReader>(replayFile);
+        if (!replay->isOpen())
+        {
+            Logger::getInstance().flush();
+            return 1;
+        }
+        Logger::getInstance().log(logInfo, "Replaying %ld ms to %ld ms of simulation time from %ld chunks",
+                                  replay->getStartTime(), replay->getEndTime(), static_cast<long>(replay->getChunkCount()));
+        Graphics graphics;
+        graphics.setBgFilename(replay->getBackgroundFilename());
+        graphics.setReplay(replay);
+        if (!videoFile.empty())
+        {
+            graphics.setVideoOutput(videoFile, fps, cv::Size(width, height));
+        }
+        graphics.simulate();
+        Logger::getInstance().flush();
+        return 0;
     }
 
-    streets.at(0)->setInIntersection(intersections.at(0));
-    streets.at(0)->setOutIntersection(intersections.at(1));
-
-    streets.at(1)->setInIntersection(intersections.at(1));
-    streets.at(1)->setOutIntersection(intersections.at(2));
-
-    streets.at(2)->setInIntersection(intersections.at(2));
-    streets.at(2)->setOutIntersection(intersections.at(3));
-
-    streets.at(3)->setInIntersection(intersections.at(3));
-    streets.at(3)->setOutIntersection(intersections.at(4));
-
-    streets.at(4)->setInIntersection(intersections.at(4));
-    streets.at(4)->setOutIntersection(intersections.at(5));
-
-    streets.at(5)->setInIntersection(intersections.at(5));
-    streets.at(5)->setOutIntersection(intersections.at(0));
-
-    streets.at(6)->setInIntersection(intersections.at(0));
-    streets.at(6)->setOutIntersection(intersections.at(3));
-
-    // add vehicles to streets
-    for (size_t nv = 0; nv < nVehicles; nv++)
-    {
-        vehicles.push_back(std::make_shared<Vehicle>());
-        vehicles.at(nv)->setCurrentStreet(streets.at(nv));
-        vehicles.at(nv)->setCurrentDestination(intersections.at(nv));
-    }
-}
-
-/* Main function */
-int main()
-{
     /* PART 1 : Set up traffic objects */
 
     // create and connect intersections and streets
@@ -124,6 +131,70 @@ int main()
     int nVehicles = 3;
     createTrafficObjects_Paris(streets, intersections, vehicles, backgroundImg, nVehicles);
 
+    // continue from a checkpoint of the same network, options below change the restored state: --restore <file>
+    // write a checkpoint once the simulation stops: --checkpoint <file>
+    std::string restoreFile, checkpointFile;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--restore")
+            restoreFile = argv[++i];
+        else if (arg == "--checkpoint")
+            checkpointFile = argv[++i];
+    }
+    if (!restoreFile.empty() && !Checkpoint(streets, intersections, vehicles).restore(restoreFile))
+    {
+        Logger::getInstance().flush();
+        return 1;
+    }
+
+    // end the simulation after running for the given simulation time in seconds and report the final metrics: --duration <s>,
+    // counted from the restored time
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::string(argv[i]) == "--duration")
+        {
+            SimulationControl::getInstance().stopAt(TrafficObject::getSimulationTime() + static_cast<long>(1000 * std::stod(argv[++i])));
+        }
+    }
+
+    // simulate all streets as queues instead of with the car-following model: --meso
+    if (std::find(argv + 1, argv + argc, std::string("--meso")) != argv + argc)
+    {
+        for (auto &street : streets)
+        {
+            street->setModel(modelMesoscopic);
+        }
+    }
+
+    // or only those outside of one or more detailed regions: --micro-region <x0>,<y0>,<x1>,<y1>
+    FidelityRegions regions;
+    bool hasRegions = false;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        double x0, y0, x1, y1;
+        if (std::string(argv[i]) == "--micro-region" && std::sscanf(argv[++i], "%lf,%lf,%lf,%lf", &x0, &y0, &x1, &y1) == 4)
+        {
+            regions.addMicroscopicRegion(x0, y0, x1, y1);
+            hasRegions = true;
+        }
+    }
+    if (hasRegions)
+    {
+        regions.apply(streets);
+    }
+
+    // switch the lights by actuated control, which extends green while vehicles keep arriving: --actuated
+    std::unique_ptr<SignalController> controller;
+    if (std::find(argv + 1, argv + argc, std::string("--actuated")) != argv + argc)
+    {
+        controller.reset(new SignalController(std::make_shared<ActuatedPolicy>()));
+        for (auto &intersection : intersections)
+        {
+            controller->addIntersection(intersection);
+        }
+    }
+
     /* PART 2 : simulate traffic objects */
 
     // simulate intersection
@@ -136,23 +207,120 @@ int main()
         v->simulate();
     });
 
-    /* PART 3 : Launch visualization */
+    if (controller)
+    {
+        controller->simulate();
+    }
 
-    // add all objects into common vector
-    std::vector<std::shared_ptr<TrafficObject>> trafficObjects;
-    std::for_each(intersections.begin(), intersections.end(), [&trafficObjects](std::shared_ptr<Intersection> &intersection) {
-        std::shared_ptr<TrafficObject> trafficObject = std::dynamic_pointer_cast<TrafficObject>(intersection);
-        trafficObjects.push_back(trafficObject);
-    });
+    // advance the vehicles on all streets with the car-following model
+    StreetScheduler scheduler;
+    scheduler.setStreets(streets);
 
-    std::for_each(vehicles.begin(), vehicles.end(), [&trafficObjects](std::shared_ptr<Vehicle> &vehicles) {
-        std::shared_ptr<TrafficObject> trafficObject = std::dynamic_pointer_cast<TrafficObject>(vehicles);
-        trafficObjects.push_back(trafficObject);
-    });
+    // record the trajectories of all vehicles every 100 ms of simulation time: --trajectory <file> [--trajectory-period <ms>],
+    // periods up to the step of the scheduler record every step
+    std::shared_ptr<TrajectoryRecorder> recorder;
+    std::string trajectoryFile;
+    long trajectoryPeriod = 100;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--trajectory")
+        {
+            trajectoryFile = argv[++i];
+        }
+        else if (arg == "--trajectory-period")
+        {
+            trajectoryPeriod = std::stol(argv[++i]);
+        }
+    }
+    if (!trajectoryFile.empty())
+    {
+        recorder = std::make_shared<TrajectoryRecorder>(trajectoryFile, trajectoryPeriod);
+        scheduler.setRecorder(recorder);
+    }
+
+    // publish a snapshot of all objects at the end of every step of the scheduler
+    auto publisher = std::make_shared<SnapshotPublisher>();
+    publisher->setTrafficObjects(vehicles, intersections);
+    std::shared_ptr<ReplayRecorder> replayRecorder;
+    if (!recordFile.empty())
+    {
+        replayRecorder = std::make_shared<ReplayRecorder>(recordFile, backgroundImg);
+        publisher->setRecorder(replayRecorder);
+    }
+    scheduler.setPublisher(publisher);
+    scheduler.simulate();
+
+    /* PART 3 : Launch visualization */
 
-    // draw all objects in vector
-    Graphics *graphics = new Graphics();
+    // draw all objects from the published snapshots
+    std::unique_ptr<Graphics> graphics(new Graphics());
     graphics->setBgFilename(backgroundImg);
-    graphics->setTrafficObjects(trafficObjects);
+    graphics->setSnapshotBuffer(publisher->getSnapshotBuffer());
+
+    if (!videoFile.empty())
+    {
+        graphics->setVideoOutput(videoFile, fps, cv::Size(width, height));
+    }
+
+    std::unique_ptr<MetricsReporter> reporter;
+    if (!metricsFile.empty())
+    {
+        reporter.reset(new MetricsReporter(metricsFile));
+        reporter->simulate();
+    }
+
+    // returns once a stop has been requested from the window or by --duration
     graphics->simulate();
+    graphics.reset();
+
+    /* PART 4 : Stop traffic objects and report */
+
+    // a warmed-up state to branch experiments from, taken while all objects are still running
+    if (!checkpointFile.empty() && !Checkpoint(streets, intersections, vehicles).save(checkpointFile))
+    {
+        Logger::getInstance().log(logError, "Checkpoint could not be written");
+    }
+    if (controller)
+    {
+        controller->stop();
+    }
+    scheduler.stop();
+    if (recorder)
+    {
+        recorder->stop();
+    }
+    if (replayRecorder)
+    {
+        replayRecorder->stop();
+    }
+    stopTrafficObjects(intersections, vehicles);
+    if (reporter)
+    {
+        reporter->stop();
+        reporter->writeSnapshot(); // final values of all metrics
+    }
+
+    long nCrossings = 0;
+    for (auto &intersection : intersections)
+    {
+        nCrossings += intersection->getThroughput();
+    }
+    Histogram &waitTime = MetricsRegistry::getInstance().getHistogram("intersection.wait_ms");
+    Logger::getInstance().log(logInfo, "Simulation stopped after %ld ms, %ld vehicles crossed intersections, wait p50 %ld ms, p99 %ld ms",
+                              TrafficObject::getSimulationTime(), nCrossings, waitTime.getPercentile(50), waitTime.getPercentile(99));
+
+    TrafficObject::getTimingWheel().cancelAndWait(traceTimer);
+    if (traceWriter.joinable())
+    {
+        traceWriter.join();
+    }
+    if (Tracer::getInstance().isEnabled())
+    {
+        Tracer::getInstance().setEnabled(false);
+        Tracer::getInstance().writeChromeTrace(traceFile);
+    }
+    releaseTrafficObjects(streets, intersections, vehicles);
+    Logger::getInstance().flush();
+    return 0;
 }
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include "Metrics.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include "Trajectory.h"
+
+void TrajectoryFrame::clear()
+{
+    vehicleIds.clear();
+    streetIds.clear();
+    positions.clear();
+    speeds.clear();
+    states.clear();
+}
+
+/* Implementation of class "TrajectoryRecorder" */
+
+TrajectoryRecorder::TrajectoryRecorder(std::string filename, long period, size_t queueCapacity)
+    : _queue(queueCapacity, MetricsRegistry::getInstance().getCounter("trajectory.dropped")),
+      _writer(filename, magic, version, "", nColumns, MetricsRegistry::getInstance().getCounter("trajectory.bytes"))
+{
+    _period = period > 0 ? period : 1;
+    _nextFrameTime = 0;
+    if (!_writer.isOpen())
+    {
+        Logger::getInstance().log(logError, "TrajectoryRecorder: file could not be opened, frames are dropped");
+    }
+    _thread = std::thread(&TrajectoryRecorder::write, this);
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    stop();
+}
+
+bool TrajectoryRecorder::beginFrame(long time, std::vector<TrajectoryFrame> &parts, size_t nParts)
+{
+    if (time < _nextFrameTime)
+    {
+        return false;
+    }
+
+    // the step of the scheduler is not held up when the writer thread falls behind, the frame is dropped instead
+    _nextFrameTime = (time / _period + 1) * _period;
+    if (!_queue.reserve(parts, nParts))
+    {
+        return false;
+    }
+    for (auto &part : parts)
+    {
+        part.clear();
+    }
+    parts[0].simulationTime = time;
+
+    return true;
+}
+
+void TrajectoryRecorder::endFrame(std::vector<TrajectoryFrame> &parts)
+{
+    TraceScope trace("endFrame");
+
+    // the rows are only concatenated here, all encoding happens in the writer thread
+    TrajectoryFrame &frame = parts[0];
+    for (size_t i = 1; i < parts.size(); ++i)
+    {
+        frame.vehicleIds.insert(frame.vehicleIds.end(), parts[i].vehicleIds.begin(), parts[i].vehicleIds.end());
+        frame.streetIds.insert(frame.streetIds.end(), parts[i].streetIds.begin(), parts[i].streetIds.end());
+        frame.positions.insert(frame.positions.end(), parts[i].positions.begin(), parts[i].positions.end());
+        frame.speeds.insert(frame.speeds.end(), parts[i].speeds.begin(), parts[i].speeds.end());
+        frame.states.insert(frame.states.end(), parts[i].states.begin(), parts[i].states.end());
+        _queue.recycle(std::move(parts[i]));
+    }
+    _queue.push(std::move(frame));
+    parts.clear();
+}
+
+void TrajectoryRecorder::stop()
+{
+    // pending frames are still written before the writer thread finishes
+    _queue.close();
+    if (_thread.joinable())
+    {
+        _thread.join();
+        if (_queue.getDropped() > 0)
+        {
+            Logger::getInstance().log(logWarning, "TrajectoryRecorder: %ld frames dropped because the writer fell behind", static_cast<long>(_queue.getDropped()));
+        }
+    }
+}
+
+void TrajectoryRecorder::write()
+{
+    Tracer::getInstance().setThreadName("TrajectoryRecorder");
+    TrajectoryFrame frame;
+    while (_queue.pop(frame))
+    {
+        encodeFrame(frame);
+        _queue.recycle(std::move(frame));
+    }
+    _writer.close();
+}
+
+void TrajectoryRecorder::encodeFrame(const TrajectoryFrame &frame)
+{
+    TraceScope trace("encodeFrame");
+    static Counter &rowsRecorded = MetricsRegistry::getInstance().getCounter("trajectory.rows");
+
+    // rows are ordered by vehicle id through a table over the id range of the frame. A vehicle which has been
+    // copied while changing streets appears on both of them, only one of its rows is kept
+    int minId = INT_MAX, maxId = -1;
+    for (int id : frame.vehicleIds)
+    {
+        minId = std::min(minId, id);
+        maxId = std::max(maxId, id);
+    }
+    const uint32_t npos = 0xffffffff;
+    _order.assign(maxId >= minId ? maxId - minId + 1 : 0, npos);
+    for (size_t row = 0; row < frame.vehicleIds.size(); ++row)
+    {
+        _order[frame.vehicleIds[row] - minId] = static_cast<uint32_t>(row);
+    }
+
+    // vehicles move little between two frames and mostly keep their speed, so every value of a row takes one or two bytes
+    uint32_t chunk = _writer.getChunk();
+    int previousId = 0;
+    uint64_t nRows = 0;
+    for (size_t slot = 0; slot < _order.size(); ++slot)
+    {
+        uint32_t row = _order[slot];
+        if (row == npos)
+        {
+            continue;
+        }
+        int id = minId + static_cast<int>(slot);
+        TrajectoryBase &base = getChunkBase(_bases, id, chunk);
+        int32_t position = static_cast<int32_t>(std::lround(frame.positions[row] * 100.0f));
+        int32_t speed = static_cast<int32_t>(std::lround(frame.speeds[row] * 100.0f));
+
+        _writer.getColumn(0).putSigned(id - previousId);
+        _writer.getColumn(1).putSigned(static_cast<int64_t>(frame.streetIds[row]) - base.streetId);
+        _writer.getColumn(2).putSigned(static_cast<int64_t>(position) - base.predictPosition(frame.simulationTime, frame.streetIds[row]));
+        _writer.getColumn(3).putSigned(static_cast<int64_t>(speed) - base.speed);
+        _writer.getColumn(4).putByte(frame.states[row]);
+
+        previousId = id;
+        base.time = frame.simulationTime;
+        base.streetId = frame.streetIds[row];
+        base.position = position;
+        base.speed = speed;
+        base.chunk = chunk;
+        ++nRows;
+    }
+
+    rowsRecorded.add(nRows);
+    _writer.addFrame(frame.simulationTime, nRows);
+}
+
+/* Implementation of class "TrajectoryReader" */
+
+TrajectoryReader::TrajectoryReader(std::string filename) : _reader(filename, TrajectoryRecorder::magic, TrajectoryRecorder::version)
+{
+    _nextChunk = 0;
+    _nextFrame = 0;
+}
+
+bool TrajectoryReader::readFrame(TrajectoryFrame &frame)
+{
+    if (_nextFrame >= _frames.size() && !readChunk())
+    {
+        return false;
+    }
+    frame = _frames[_nextFrame++];
+    return true;
+}
+
+bool TrajectoryReader::readChunk()
+{
+    ChunkLayout layout;
+    if (!_reader.isOpen() || !_reader.readChunk(_nextChunk, _raw) || !layout.parse(_raw, TrajectoryRecorder::nColumns))
+    {
+        return false;
+    }
+    uint32_t chunk = static_cast<uint32_t>(++_nextChunk); // chunks are numbered from 1 like in the recorder
+
+    _frames.resize(layout.times.size());
+    for (size_t f = 0; f < _frames.size(); ++f)
+    {
+        TrajectoryFrame &frame = _frames[f];
+        frame.clear();
+        frame.simulationTime = layout.times[f];
+        int id = 0;
+        for (uint64_t row = 0; row < layout.nRows[f]; ++row)
+        {
+            id += static_cast<int>(layout.columns[0].getSigned());
+            if (id < 0 || id > maxLogVehicleId)
+            {
+                return false;
+            }
+            TrajectoryBase &base = getChunkBase(_bases, id, chunk);
+            int32_t streetId = base.streetId + static_cast<int32_t>(layout.columns[1].getSigned());
+            base.position = base.predictPosition(frame.simulationTime, streetId) + static_cast<int32_t>(layout.columns[2].getSigned());
+            base.speed += static_cast<int32_t>(layout.columns[3].getSigned());
+            base.streetId = streetId;
+            base.time = frame.simulationTime;
+            base.chunk = chunk;
+
+            frame.vehicleIds.push_back(id);
+            frame.streetIds.push_back(base.streetId);
+            frame.positions.push_back(base.position / 100.0f);
+            frame.speeds.push_back(base.speed / 100.0f);
+            frame.states.push_back(layout.columns[4].getByte());
+        }
+    }
+    for (auto &column : layout.columns)
+    {
+        if (!column.isValid())
+        {
+            return false;
+        }
+    }
+    _nextFrame = 0;
+
+    return true;
+}
@@ -0,0 +1,112 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ChunkLog.h"
+
+// state of all vehicles on the streets at one point in simulation time, one row per vehicle
+struct TrajectoryFrame
+{
+    long simulationTime = 0;      // in ms
+    std::vector<int> vehicleIds;
+    std::vector<int> streetIds;
+    std::vector<float> positions; // distance from the start of the street in the driving direction, recorded in cm
+    std::vector<float> speeds;    // recorded in cm/s
+    std::vector<uint8_t> states;  // Street::LaneState flags, the lane of the street above Street::laneShift, at most Street::maxRecordedLane
+
+    void clear();
+};
+
+// values of the previous row of a vehicle in the current chunk, the next row stores the differences to them
+struct TrajectoryBase
+{
+    uint32_t chunk = 0; // values are zero in a chunk which does not contain a row of the vehicle yet
+    long time = 0;
+    int32_t streetId = 0, position = 0, speed = 0;
+
+    // position expected at the given time on the given street, a vehicle on a new street is expected at its start
+    int32_t predictPosition(long nextTime, int32_t nextStreetId) const
+    {
+        return nextStreetId == streetId ? position + static_cast<int32_t>(static_cast<int64_t>(speed) * (nextTime - time) / 1000) : 0;
+    }
+};
+
+// records the trajectories of all vehicles into a columnar file. Whenever a frame is due, the street scheduler
+// copies the vehicles of every street right after updating it (see StreetScheduler::setRecorder), the frame is
+// then handed over through a FrameQueue to a writer thread, which encodes it. Frames which are due while the
+// queue is full are dropped and counted, so a slow disk never holds up the scheduler.
+//
+// File layout: a chunked log (see ChunkWriter) with magic "TSTJ" and no header data. Chunks have no chunk header,
+// their columns are: vehicle id (delta to the previous row, rows are ordered by vehicle id), street id and speed
+// (deltas to the previous row of the same vehicle), position (difference to the position predicted from the
+// previous row, see TrajectoryBase) and the state as raw bytes. All integers within a chunk are (zigzag) varints,
+// see ColumnCodec.
+class TrajectoryRecorder
+{
+public:
+    // file format
+    static constexpr uint32_t magic = 0x4a545354; // "TSTJ"
+    static constexpr uint32_t version = 2;
+    static constexpr int nColumns = 5;
+
+    // constructor / desctructor
+    TrajectoryRecorder(std::string filename, long period = 100, size_t queueCapacity = 4);
+    ~TrajectoryRecorder();
+
+    // getters / setters
+    void setFramesPerChunk(int nFrames) { _writer.setFramesPerChunk(nFrames); } // before the first frame
+    uint64_t getBytesWritten() { return _writer.getBytesWritten(); }
+    uint64_t getDroppedFrames() { return _queue.getDropped(); }
+
+    // typical behaviour methods
+    bool beginFrame(long time, std::vector<TrajectoryFrame> &parts, size_t nParts); // returns false if no frame is due at this time or it is dropped
+    void endFrame(std::vector<TrajectoryFrame> &parts); // merges the parts copied by the threads of the scheduler and queues the frame
+    void stop(); // writes all pending frames and closes the file, the scheduler has to be stopped before
+
+private:
+    // typical behaviour methods
+    void write(); // executed in the writer thread
+    void encodeFrame(const TrajectoryFrame &frame);
+
+    // private members
+    long _period;                                 // in ms
+    long _nextFrameTime;                          // only used by the thread of the scheduler
+    FrameQueue<TrajectoryFrame> _queue;
+    std::thread _thread;
+
+    // only used by the writer thread
+    ChunkWriter _writer;
+    std::vector<uint32_t> _order;                 // row of every vehicle id of a frame
+    std::vector<TrajectoryBase> _bases;           // indexed by vehicle id
+};
+
+// reads the frames of a trajectory file in order, decoding one chunk at a time
+class TrajectoryReader
+{
+public:
+    // constructor / desctructor
+    TrajectoryReader(std::string filename);
+
+    // getters / setters
+    bool isOpen() { return _reader.isOpen(); }
+
+    // typical behaviour methods
+    bool readFrame(TrajectoryFrame &frame); // returns false at the end of the file or if the file is corrupt
+
+private:
+    // typical behaviour methods
+    bool readChunk();
+
+    // private members
+    ChunkReader _reader;
+    size_t _nextChunk;
+    std::vector<TrajectoryFrame> _frames;         // frames of the current chunk
+    size_t _nextFrame;
+    std::vector<TrajectoryBase> _bases;           // indexed by vehicle id
+    std::string _raw;
+};
+
+#endif
@@ -1,15 +1,23 @@
+#include <cmath>
 #include <iostream>
 #include <random>
 #include "Street.h"
 #include "Intersection.h"
 #include "Vehicle.h"
+#include "RenderAttributes.h"
+#include "Logger.h"
+#include "SimulationControl.h"
+#include "Tracer.h"
 
-Vehicle::Vehicle()
+Vehicle::Vehicle(int id) : TrafficObject(id)
 {
     _currStreet = nullptr;
-    _posStreet = 0.0;
     _type = ObjectType::objectVehicle;
-    _speed = 400; // m/s
+    _streetEvents = 0;
+    _routeChoice = routeRandom;
+
+    // render attributes are computed once, the renderer only looks them up by id
+    RenderAttributeTable::getInstance().set(_id, RenderAttributeTable::createVehicleAttributes(_id));
 }
 
 
@@ -17,9 +25,6 @@ void Vehicle::setCurrentDestination(std::shared_ptr<Intersection> destination)
 {
     // update destination
     _currDestination = destination;
-
-    // reset simulation parameters
-    _posStreet = 0.0;
 }
 
 void Vehicle::simulate()
@@ -32,102 +37,170 @@ void Vehicle::simulate()
     //_threads.emplace_back(std::thread(&Vehicle::drive, this));
 }
 
+void Vehicle::stop()
+{
+    // wake up the vehicle thread if it is waiting for street events
+    {
+        std::lock_guard<std::mutex> lock(_eventMutex);
+        _isStopping = true;
+        _eventCondition.notify_one();
+    }
+    joinThreads();
+}
+
+void Vehicle::notifyStreetEvent(StreetEvent event)
+{
+    std::lock_guard<std::mutex> lock(_eventMutex);
+    _streetEvents |= event;
+    _eventCondition.notify_one();
+}
+
+int Vehicle::waitForStreetEvents(int events)
+{
+    TraceScope trace("waitForStreetEvents");
+    std::unique_lock<std::mutex> lock(_eventMutex);
+    _eventCondition.wait(lock, [this, events] { return (_streetEvents & events) != 0 || _isStopping; });
+    events &= _streetEvents;
+    _streetEvents &= ~events;
+    return events;
+}
+
 // virtual function which is executed in a thread
 void Vehicle::drive()
 {
-    // print id of the current thread
-    std::unique_lock<std::mutex> lck(_mtx);
-    std::cout << "Vehicle #" << _id << "::drive: thread id = " << std::this_thread::get_id() << std::endl;
-    lck.unlock();
-
-    // initalize variables
-    bool hasEnteredIntersection = false;
-    double cycleDuration = 1; // duration of a single simulation cycle in ms
-    std::chrono::time_point<std::chrono::system_clock> lastUpdate;
-
-    // init stop watch
-    lastUpdate = std::chrono::system_clock::now();
-    while (true)
-    {
-        // sleep at every iteration to reduce CPU usage
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // the index of the current thread is part of every log record
+    Logger::getInstance().log(logDebug, "Vehicle #%ld::drive: started", _id);
+    Tracer::getInstance().setThreadName("Vehicle #" + std::to_string(_id));
 
-        // compute time difference to stop watch
-        long timeSinceLastUpdate = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - lastUpdate).count();
-        if (timeSinceLastUpdate >= cycleDuration)
+    // enter the initial street unless the vehicle has been placed on it, waiting for room if it is backed up to its start
+    std::shared_lock<std::shared_mutex> stateLock(SimulationControl::getInstance().getStateMutex());
+    while (_laneHandle.lane < 0 && !_currStreet->enter(get_shared_this(), _currDestination, 0.0, _laneHandle))
+    {
+        _currStreet->requestRoom(get_shared_this(), _currDestination);
+        stateLock.unlock();
+        waitForStreetEvents(eventRoomAvailable);
+        if (_isStopping)
         {
-            // update position with a constant velocity motion model
-            _posStreet += _speed * timeSinceLastUpdate / 1000;
-
-            // compute completion rate of current street
-            double completion = _posStreet / _currStreet->getLength();
-
-            // compute current pixel position on street based on driving direction
-            std::shared_ptr<Intersection> i1, i2;
-            i2 = _currDestination;
-            i1 = i2->getID() == _currStreet->getInIntersection()->getID() ? _currStreet->getOutIntersection() : _currStreet->getInIntersection();
-
-            double x1, y1, x2, y2, xv, yv, dx, dy, l;
-            i1->getPosition(x1, y1);
-            i2->getPosition(x2, y2);
-            dx = x2 - x1;
-            dy = y2 - y1;
-            l = sqrt((x1 - x2) * (x1 - x2) + (y1 - y2) * (x1 - x2));
-            xv = x1 + completion * dx; // new position based on line equation in parameter form
-            yv = y1 + completion * dy;
-            this->setPosition(xv, yv);
-
-            // check wether halting position in front of destination has been reached
-            if (completion >= 0.9 && !hasEnteredIntersection)
-            {
-                // request entry to the current intersection (using async)
-                auto ftrEntryGranted = std::async(&Intersection::addVehicleToQueue, _currDestination, get_shared_this());
+            return;
+        }
+        stateLock.lock();
+    }
+    stateLock.unlock();
 
-                // wait until entry has been granted
-                ftrEntryGranted.get();
+    // position and speed are advanced by the street, the vehicle only reacts to the events it signals
+    while (!_isStopping)
+    {
+        int events = waitForStreetEvents();
 
-                // slow down and set intersection flag
-                _speed /= 10.0;
-                hasEnteredIntersection = true;
-            }
+        // check wether the vehicle has to stop in front of its destination
+        if (events & eventApproaching)
+        {
+            // request entry to the current intersection (using async)
+            auto ftrEntryGranted = std::async(&Intersection::addVehicleToQueue, _currDestination, get_shared_this());
 
-            // check wether intersection has been crossed
-            if (completion >= 1.0 && hasEnteredIntersection)
+            // wait until entry has been granted
             {
-                // choose next street and destination
-                std::vector<std::shared_ptr<Street>> streetOptions = _currDestination->queryStreets(_currStreet);
-                std::shared_ptr<Street> nextStreet;
-                if (streetOptions.size() > 0)
-                {
-                    // pick one street at random and query intersection to enter this street
-                    std::random_device rd;
-                    std::mt19937 eng(rd());
-                    std::uniform_int_distribution<> distr(0, streetOptions.size() - 1);
-                    nextStreet = streetOptions.at(distr(eng));
-                }
-                else
-                {
-                    // this street is a dead-end, so drive back the same way
-                    nextStreet = _currStreet;
-                }
-                
-                // pick the one intersection at which the vehicle is currently not
-                std::shared_ptr<Intersection> nextIntersection = nextStreet->getInIntersection()->getID() == _currDestination->getID() ? nextStreet->getOutIntersection() : nextStreet->getInIntersection(); 
-
-                // send signal to intersection that vehicle has left the intersection
-                _currDestination->vehicleHasLeft(get_shared_this());
-
-                // assign new street and destination
-                this->setCurrentDestination(nextIntersection);
-                this->setCurrentStreet(nextStreet);
-
-                // reset speed and intersection flag
-                _speed *= 10.0;
-                hasEnteredIntersection = false;
+                TraceScope trace("ftrEntryGranted.get");
+                ftrEntryGranted.get();
             }
 
-            // reset stop watch for next cycle
-            lastUpdate = std::chrono::system_clock::now();
+            // the vehicle may now pass the stop line, it slows down inside the intersection
+            _currStreet->grantEntry(_laneHandle);
+        }
+
+        // check wether intersection has been crossed
+        if (events & eventExitReached)
+        {
+            enterNextStreet();
         }
     } // eof simulation loop
 }
+
+void Vehicle::enterNextStreet()
+{
+    // choose next street and destination
+    std::vector<std::shared_ptr<Street>> streetOptions = _currDestination->queryStreets(_currStreet);
+    std::shared_ptr<Street> nextStreet;
+    if (streetOptions.size() > 0 && _routeChoice == routeStraight)
+    {
+        nextStreet = chooseStraightStreet(streetOptions);
+    }
+    else if (streetOptions.size() > 0)
+    {
+        // pick one street at random and query intersection to enter this street
+        std::random_device rd;
+        std::mt19937 eng(rd());
+        std::uniform_int_distribution<> distr(0, streetOptions.size() - 1);
+        nextStreet = streetOptions.at(distr(eng));
+    }
+    else
+    {
+        // this street is a dead-end, so drive back the same way
+        nextStreet = _currStreet;
+    }
+
+    // pick the one intersection at which the vehicle is currently not
+    std::shared_ptr<Intersection> nextIntersection = nextStreet->getInIntersection()->getID() == _currDestination->getID() ? nextStreet->getOutIntersection() : nextStreet->getInIntersection();
+
+    // wait at the end of the current street until there is room on the next one, which lets queues spill back.
+    // The vehicle is on both streets until it has left the current one, which a checkpoint must not see
+    TraceScope trace("enterNextStreet");
+    LaneHandle nextHandle;
+    std::shared_lock<std::shared_mutex> stateLock(SimulationControl::getInstance().getStateMutex());
+    while (!nextStreet->enter(get_shared_this(), nextIntersection, _currStreet->getSpeed(_laneHandle), nextHandle))
+    {
+        nextStreet->requestRoom(get_shared_this(), nextIntersection);
+        stateLock.unlock();
+        waitForStreetEvents(eventRoomAvailable);
+        if (_isStopping)
+        {
+            return;
+        }
+        stateLock.lock();
+    }
+    _currStreet->leave(_laneHandle);
+
+    // send signal to intersection that vehicle has left the intersection
+    _currDestination->vehicleHasLeft(get_shared_this());
+
+    // assign new street and destination
+    this->setCurrentDestination(nextIntersection);
+    this->setCurrentStreet(nextStreet);
+    _laneHandle = nextHandle;
+}
+
+std::shared_ptr<Street> Vehicle::chooseStraightStreet(std::vector<std::shared_ptr<Street>> &streetOptions)
+{
+    // direction in which the vehicle arrives at its destination
+    double x0, y0, x1, y1;
+    std::shared_ptr<Intersection> origin = _currStreet->getInIntersection() == _currDestination ? _currStreet->getOutIntersection() : _currStreet->getInIntersection();
+    origin->getPosition(x0, y0);
+    _currDestination->getPosition(x1, y1);
+    double dx = x1 - x0, dy = y1 - y0;
+
+    // the street with the smallest angle to that direction is taken, ties (turns at the end of a corridor) are broken at random
+    std::vector<std::shared_ptr<Street>> straightest;
+    double bestCosine = -2.0;
+    for (auto &street : streetOptions)
+    {
+        double x2, y2;
+        std::shared_ptr<Intersection> next = street->getInIntersection() == _currDestination ? street->getOutIntersection() : street->getInIntersection();
+        next->getPosition(x2, y2);
+        double ex = x2 - x1, ey = y2 - y1;
+        double norm = std::sqrt((dx * dx + dy * dy) * (ex * ex + ey * ey));
+        double cosine = norm > 0.0 ? (dx * ex + dy * ey) / norm : -1.0;
+        if (cosine > bestCosine + 1e-6)
+        {
+            bestCosine = cosine;
+            straightest.clear();
+        }
+        if (cosine > bestCosine - 1e-6)
+        {
+            straightest.push_back(street);
+        }
+    }
+    std::random_device rd;
+    std::mt19937 eng(rd());
+    std::uniform_int_distribution<> distr(0, straightest.size() - 1);
+    return straightest.at(distr(eng));
+}
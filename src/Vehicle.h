@@ -1,24 +1,47 @@
 #ifndef VEHICLE_H
 #define VEHICLE_H
 
+#include <condition_variable>
 #include "TrafficObject.h"
+#include "Street.h"
 
 // forward declarations to avoid include cycle
 class Street;
 class Intersection;
 
+// how a vehicle chooses the next street at an intersection
+enum RouteChoice
+{
+    routeRandom,   // any street except the one it arrives on
+    routeStraight, // the street which continues its direction best, e.g. along a corridor
+};
+
 class Vehicle : public TrafficObject, public std::enable_shared_from_this<Vehicle>
 {
 public:
+    // events signalled by the street on which the vehicle is driving
+    enum StreetEvent
+    {
+        eventApproaching = 1, // vehicle has to request entry to its destination before reaching the stop line
+        eventExitReached = 2, // vehicle has crossed its destination and needs a new street
+        eventRoomAvailable = 4, // street which the vehicle could not enter has room now, see Street::requestRoom
+    };
+
     // constructor / desctructor
-    Vehicle();
+    Vehicle(int id = newID);
 
     // getters / setters
     void setCurrentStreet(std::shared_ptr<Street> street) { _currStreet = street; };
+    std::shared_ptr<Street> getCurrentStreet() { return _currStreet; }
     void setCurrentDestination(std::shared_ptr<Intersection> destination);
+    std::shared_ptr<Intersection> getCurrentDestination() { return _currDestination; }
+    void setLaneHandle(const LaneHandle &handle) { _laneHandle = handle; } // vehicle has already entered its current street
+    void setRouteChoice(RouteChoice routeChoice) { _routeChoice = routeChoice; }                 // before the vehicle is simulated
 
     // typical behaviour methods
     void simulate();
+    void stop();
+    void notifyStreetEvent(StreetEvent event);
 
     // miscellaneous
     std::shared_ptr<Vehicle> get_shared_this() { return shared_from_this(); }
@@ -26,11 +49,17 @@ public:
 private:
     // typical behaviour methods
     void drive();
+    int waitForStreetEvents(int events = eventApproaching | eventExitReached); // returns and clears the pending events of the set
+    void enterNextStreet();
+    std::shared_ptr<Street> chooseStraightStreet(std::vector<std::shared_ptr<Street>> &streetOptions);
 
     std::shared_ptr<Street> _currStreet;            // street on which the vehicle is currently on
     std::shared_ptr<Intersection> _currDestination; // destination to which the vehicle is currently driving
-    double _posStreet;                              // position on current street
-    double _speed;                                  // ego speed in m/s
+    LaneHandle _laneHandle;                         // position and speed are kept in the lanes of the current street
+    RouteChoice _routeChoice;
+    int _streetEvents;                              // pending street events, bitwise or of StreetEvent
+    std::mutex _eventMutex;
+    std::condition_variable _eventCondition;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include <opencv2/imgproc.hpp>
+#include "VideoEncoder.h"
+#include "Logger.h"
+
+/* Implementation of class "VideoEncoder" */
+
+VideoEncoder::VideoEncoder(std::string filename, double fps, cv::Size resolution, size_t queueCapacity)
+{
+    _filename = filename;
+    _fps = fps;
+    _resolution = resolution;
+    _queueCapacity = queueCapacity > 0 ? queueCapacity : 1;
+    _isRunning = true;
+    _thread = std::thread(&VideoEncoder::encode, this);
+}
+
+VideoEncoder::~VideoEncoder()
+{
+    stop();
+}
+
+void VideoEncoder::pushFrame(const cv::Mat &frame)
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    _notFull.wait(lck, [this] { return _frames.size() < _queueCapacity || !_isRunning; });
+    if (!_isRunning)
+    {
+        return;
+    }
+
+    // the frame is copied, as the renderer keeps drawing into its images
+    _frames.push_back(frame.clone());
+    _notEmpty.notify_one();
+}
+
+void VideoEncoder::stop()
+{
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        _isRunning = false;
+        _notEmpty.notify_all();
+        _notFull.notify_all();
+    }
+    if (_thread.joinable())
+    {
+        _thread.join();
+    }
+}
+
+void VideoEncoder::encode()
+{
+    while (true)
+    {
+        // wait for the next frame, pending frames are still encoded after stop has been called
+        std::unique_lock<std::mutex> lck(_mutex);
+        _notEmpty.wait(lck, [this] { return !_frames.empty() || !_isRunning; });
+        if (_frames.empty())
+        {
+            break;
+        }
+        cv::Mat frame = std::move(_frames.front());
+        _frames.pop_front();
+        _notFull.notify_one();
+        lck.unlock();
+
+        // open the file once the size of the first frame is known
+        if (!_writer.isOpened())
+        {
+            if (_resolution.empty())
+            {
+                _resolution = frame.size();
+            }
+            if (!_writer.open(_filename, cv::VideoWriter::fourcc('m', 'p', '4', 'v'), _fps, _resolution))
+            {
+                Logger::getInstance().log(logError, "VideoEncoder: file could not be opened, frames are dropped");
+
+                // release the renderer, all further frames are dropped
+                std::lock_guard<std::mutex> lock(_mutex);
+                _isRunning = false;
+                _frames.clear();
+                _notFull.notify_all();
+                break;
+            }
+        }
+
+        if (frame.size().width != _resolution.width || frame.size().height != _resolution.height)
+        {
+            cv::Mat resized;
+            cv::resize(frame, resized, _resolution, 0, 0, cv::INTER_AREA);
+            frame = resized;
+        }
+        _writer.write(frame);
+    }
+
+    _writer.release();
+}
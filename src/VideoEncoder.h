@@ -0,0 +1,45 @@
+#ifndef VIDEOENCODER_H
+#define VIDEOENCODER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+// encodes rendered frames into a video file in a pipeline thread of its own. Frames are handed over
+// through a bounded queue, so encoding never runs on the render thread and memory stays bounded.
+class VideoEncoder
+{
+public:
+    // constructor / desctructor
+    VideoEncoder(std::string filename, double fps, cv::Size resolution = cv::Size(), size_t queueCapacity = 8);
+    ~VideoEncoder();
+
+    // getters / setters
+    double getFps() { return _fps; }
+
+    // typical behaviour methods
+    void pushFrame(const cv::Mat &frame); // blocks while the queue is full
+    void stop();                          // encodes all pending frames and closes the file
+
+private:
+    // typical behaviour methods
+    void encode();
+
+    // private members
+    std::string _filename;
+    double _fps;
+    cv::Size _resolution;         // output resolution, the size of the first frame if empty
+    cv::VideoWriter _writer;
+    std::deque<cv::Mat> _frames;  // frames waiting to be encoded
+    size_t _queueCapacity;
+    bool _isRunning;
+    std::condition_variable _notEmpty, _notFull;
+    std::mutex _mutex;
+    std::thread _thread;
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include "WorkerPool.h"
+
+/* Implementation of class "WorkerPool" */
+
+WorkerPool::WorkerPool(int nThreads)
+{
+    _nThreads = nThreads > 0 ? nThreads : 1;
+    _work = nullptr;
+    _nTasks = 0;
+    _nextTask = 0;
+    _batch = 0;
+    _nWanted = 0;
+    _nBusy = 0;
+    _isStopping = false;
+}
+
+WorkerPool::~WorkerPool()
+{
+    stopWorkers();
+}
+
+void WorkerPool::setThreads(int nThreads)
+{
+    nThreads = nThreads > 0 ? nThreads : 1;
+    if (nThreads != _nThreads)
+    {
+        stopWorkers();
+        _nThreads = nThreads;
+    }
+}
+
+void WorkerPool::run(size_t nTasks, const std::function<void(size_t task)> &work)
+{
+    // a single task or a single thread does not need the workers
+    size_t nWanted = std::min(static_cast<size_t>(_nThreads), nTasks) - (nTasks > 0 ? 1 : 0);
+    if (nWanted == 0)
+    {
+        for (size_t task = 0; task < nTasks; ++task)
+        {
+            work(task);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_workers.size() < static_cast<size_t>(_nThreads - 1))
+    {
+        _workers.emplace_back(&WorkerPool::work, this, _workers.size());
+    }
+    _work = &work;
+    _nTasks = nTasks;
+    _nextTask = 0;
+    _nWanted = nWanted;
+    _nBusy = nWanted;
+    ++_batch;
+    _batchStarted.notify_all();
+    lock.unlock();
+
+    runTasks();
+
+    lock.lock();
+    _batchFinished.wait(lock, [this] { return _nBusy == 0; });
+    _work = nullptr;
+}
+
+void WorkerPool::runTasks()
+{
+    // tasks are taken one at a time, so threads which finish early help with the remaining ones
+    for (size_t task = _nextTask++; task < _nTasks; task = _nextTask++)
+    {
+        (*_work)(task);
+    }
+}
+
+void WorkerPool::work(size_t worker)
+{
+    uint64_t batch = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true)
+    {
+        // only the first workers take part in a batch with few tasks, the others keep waiting
+        _batchStarted.wait(lock, [this, &batch, worker] { return _isStopping || (_batch != batch && worker < _nWanted); });
+        if (_isStopping)
+        {
+            return;
+        }
+        batch = _batch;
+        lock.unlock();
+
+        runTasks();
+
+        lock.lock();
+        if (--_nBusy == 0)
+        {
+            _batchFinished.notify_one();
+        }
+    }
+}
+
+void WorkerPool::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isStopping = true;
+        _batchStarted.notify_all();
+    }
+    for (auto &worker : _workers)
+    {
+        worker.join();
+    }
+    _workers.clear();
+    _isStopping = false;
+}
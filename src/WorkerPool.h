@@ -0,0 +1,49 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// persistent threads which run the tasks of a batch together with the calling thread. The threads are started
+// with the first batch which needs them and wait for the next batch afterwards, so a batch only costs a wakeup
+// instead of starting threads. Batches must not be run concurrently or from within a task.
+class WorkerPool
+{
+public:
+    // constructor / desctructor
+    WorkerPool(int nThreads = 1);
+    ~WorkerPool();
+
+    // getters / setters
+    void setThreads(int nThreads); // threads including the calling one, must not be called while a batch runs
+    int getThreads() { return _nThreads; }
+
+    // typical behaviour methods
+    void run(size_t nTasks, const std::function<void(size_t task)> &work); // returns once all tasks have been run
+
+private:
+    // typical behaviour methods
+    void work(size_t worker); // executed in every worker thread
+    void runTasks();
+    void stopWorkers();
+
+    // private members
+    int _nThreads;
+    std::vector<std::thread> _workers;
+    const std::function<void(size_t task)> *_work; // tasks of the running batch
+    size_t _nTasks;
+    std::atomic<size_t> _nextTask;
+    uint64_t _batch;                               // incremented for every batch, workers wait for a new one
+    size_t _nWanted;                               // workers taking part in the running batch
+    size_t _nBusy;                                 // of which have not finished yet
+    bool _isStopping;
+    std::condition_variable _batchStarted, _batchFinished;
+    std::mutex _mutex;
+};
+
+#endif